@@ -0,0 +1,195 @@
+#include "dataset.h"
+#include "disparity_metrics.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <set>
+#include <sys/stat.h>
+
+/**
+ * @file dataset.cpp
+ * @brief Directory walking (POSIX dirent) and pair loading for the batch evaluation tools.
+ */
+
+static std::string join_path(const std::string &directory, const std::string &name)
+{
+    if (directory.empty() || directory[directory.size() - 1] == '/')
+        return directory + name;
+    return directory + "/" + name;
+}
+
+static bool list_directory(const std::string &path, std::set<std::string> &files, std::set<std::string> &directories)
+{
+    DIR *handle = opendir(path.c_str());
+    if (!handle)
+        return false;
+
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != 0)
+    {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+            continue;
+        struct stat info;
+        if (stat(join_path(path, name).c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode))
+            directories.insert(name);
+        else if (S_ISREG(info.st_mode))
+            files.insert(name);
+    }
+    closedir(handle);
+    return true;
+}
+
+/**
+ * @brief Adds one pair per left image of a KITTI split (e.g. image_2/000000_10.png + image_3/000000_10.png).
+ */
+static void scan_kitti_split(const std::string &directory, const std::string &name,
+                             const std::string &left_dir, const std::string &right_dir,
+                             const std::set<std::string> &directories, std::vector<sgm_stereo_pair> &pairs)
+{
+    static const char *const gt_dirs[] = {"disp_noc_0", "disp_occ_0", "disp_noc", "disp_occ"};
+
+    std::string gt_dir;
+    for (size_t i = 0; i < sizeof(gt_dirs) / sizeof(gt_dirs[0]) && gt_dir.empty(); i++)
+    {
+        if (directories.count(gt_dirs[i]))
+            gt_dir = gt_dirs[i];
+    }
+
+    std::set<std::string> left_files, right_files, gt_files, unused;
+    list_directory(join_path(directory, left_dir), left_files, unused);
+    list_directory(join_path(directory, right_dir), right_files, unused);
+    if (!gt_dir.empty())
+        list_directory(join_path(directory, gt_dir), gt_files, unused);
+
+    for (std::set<std::string>::const_iterator it = left_files.begin(); it != left_files.end(); ++it)
+    {
+        if (it->size() < 4 || it->substr(it->size() - 4) != ".png" || !right_files.count(*it))
+            continue;
+        sgm_stereo_pair pair;
+        pair.name = join_path(name, *it);
+        pair.left_path = join_path(join_path(directory, left_dir), *it);
+        pair.right_path = join_path(join_path(directory, right_dir), *it);
+        pair.gt_path = gt_files.count(*it) ? join_path(join_path(directory, gt_dir), *it) : std::string();
+        pair.gt_scale = SGM_GT_SCALE_KITTI;
+        pairs.push_back(pair);
+    }
+}
+
+static void scan_directory(const std::string &directory, const std::string &name, std::vector<sgm_stereo_pair> &pairs)
+{
+    std::set<std::string> files, directories;
+    if (!list_directory(directory, files, directories))
+        return;
+
+    sgm_stereo_pair pair;
+    pair.name = name.empty() ? std::string(".") : name;
+    pair.gt_scale = SGM_GT_SCALE_PFM;
+
+    if (files.count("im0.png") && files.count("im1.png"))
+    {
+        pair.left_path = join_path(directory, "im0.png");
+        pair.right_path = join_path(directory, "im1.png");
+        if (files.count("disp0GT.pfm"))
+            pair.gt_path = join_path(directory, "disp0GT.pfm");
+        else if (files.count("disp0.pfm"))
+            pair.gt_path = join_path(directory, "disp0.pfm");
+        pairs.push_back(pair);
+    }
+    else if (files.count("view1.png") && files.count("view5.png"))
+    {
+        pair.left_path = join_path(directory, "view1.png");
+        pair.right_path = join_path(directory, "view5.png");
+        if (files.count("disp1.png"))
+            pair.gt_path = join_path(directory, "disp1.png");
+        pair.gt_scale = SGM_GT_SCALE_MB_PNG;
+        pairs.push_back(pair);
+    }
+    else if (files.count("left.png") && files.count("right.png"))
+    {
+        pair.left_path = join_path(directory, "left.png");
+        pair.right_path = join_path(directory, "right.png");
+        if (files.count("Ground_Truth.png"))
+            pair.gt_path = join_path(directory, "Ground_Truth.png");
+        pair.gt_scale = SGM_GT_SCALE_MB_PNG;
+        pairs.push_back(pair);
+    }
+
+    // KITTI splits keep left/right/ground truth in sibling directories
+    static const char *const kitti_splits[][2] = {{"image_2", "image_3"}, {"colored_0", "colored_1"}, {"image_0", "image_1"}};
+    std::set<std::string> consumed;
+    for (size_t i = 0; i < sizeof(kitti_splits) / sizeof(kitti_splits[0]); i++)
+    {
+        if (directories.count(kitti_splits[i][0]) && directories.count(kitti_splits[i][1]))
+        {
+            scan_kitti_split(directory, name, kitti_splits[i][0], kitti_splits[i][1], directories, pairs);
+            consumed.insert(kitti_splits[i][0]);
+            consumed.insert(kitti_splits[i][1]);
+            break; // One split per sequence directory (color preferred over gray)
+        }
+    }
+
+    for (std::set<std::string>::const_iterator it = directories.begin(); it != directories.end(); ++it)
+    {
+        if (!consumed.count(*it) && it->compare(0, 5, "disp_") != 0)
+            scan_directory(join_path(directory, *it), name.empty() ? *it : join_path(name, *it), pairs);
+    }
+}
+
+static bool pair_name_less(const sgm_stereo_pair &a, const sgm_stereo_pair &b)
+{
+    return a.name < b.name;
+}
+
+bool sgm_scan_dataset(const std::string &root, std::vector<sgm_stereo_pair> &pairs, std::string &error)
+{
+    std::set<std::string> files, directories;
+    if (!list_directory(root, files, directories))
+    {
+        error = "cannot open dataset directory " + root;
+        return false;
+    }
+
+    pairs.clear();
+    scan_directory(root, "", pairs);
+    std::sort(pairs.begin(), pairs.end(), pair_name_less);
+    if (pairs.empty())
+    {
+        error = "no stereo pairs found below " + root;
+        return false;
+    }
+    return true;
+}
+
+bool sgm_load_pair(const sgm_stereo_pair &pair, int max_cols, int max_rows, sgm_loaded_pair &loaded, std::string &error)
+{
+    sgm_image left_raw, right_raw;
+    if (!sgm_read_image(pair.left_path, left_raw, error) || !sgm_read_image(pair.right_path, right_raw, error))
+        return false;
+    if (left_raw.width != right_raw.width || left_raw.height != right_raw.height)
+    {
+        error = pair.name + ": left and right image sizes differ";
+        return false;
+    }
+
+    // Largest grid within the engine maxima that keeps the aspect ratio (never upsampled)
+    double scale = std::min(1.0, std::min((double)max_cols / left_raw.width, (double)max_rows / left_raw.height));
+    loaded.cols = std::max(1, (int)(left_raw.width * scale));
+    loaded.rows = std::max(1, (int)(left_raw.height * scale));
+
+    loaded.left = sgm_resize_area(sgm_to_gray(left_raw), loaded.cols, loaded.rows, false);
+    loaded.right = sgm_resize_area(sgm_to_gray(right_raw), loaded.cols, loaded.rows, false);
+
+    loaded.ground_truth = sgm_image();
+    loaded.ground_truth.width = loaded.ground_truth.height = loaded.ground_truth.channels = 0;
+    if (!pair.gt_path.empty())
+    {
+        sgm_image gt_raw;
+        if (!sgm_read_image(pair.gt_path, gt_raw, error))
+            return false;
+        loaded.ground_truth = sgm_prepare_ground_truth(gt_raw, loaded.cols, loaded.rows, pair.gt_scale);
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef SGM_DATASET_H
+#define SGM_DATASET_H
+
+#include "image_io.h"
+#include <string>
+#include <vector>
+
+/**
+ * @file dataset.h
+ * @brief Discovery and loading of stereo pairs from local Middlebury / KITTI style dataset trees.
+ *
+ * Recognized layouts (searched recursively):
+ * - Middlebury 2014:       <scene>/im0.png, im1.png, disp0GT.pfm (or disp0.pfm)
+ * - Middlebury 2005/2006:  <scene>/view1.png, view5.png, disp1.png
+ * - This repository:       <dir>/left.png, right.png, Ground_Truth.png
+ * - KITTI 2015 / 2012:     image_2 + image_3 (or colored_0 + colored_1, image_0 + image_1) with
+ *                          disp_noc_0 / disp_occ_0 / disp_noc / disp_occ 16-bit ground truth
+ */
+
+/* --- Ground-truth encodings: stored intensity levels per pixel of disparity --- */
+#define SGM_GT_SCALE_PFM 1.0      // Middlebury 2014 float maps
+#define SGM_GT_SCALE_MB_PNG 4.0   // Middlebury 2005/2006 PNG (same encoding as data/raw/Ground_Truth.png)
+#define SGM_GT_SCALE_KITTI 256.0  // KITTI uint16 PNG
+
+/**
+ * @brief File paths of one stereo pair; gt_path is empty when no ground truth is available.
+ */
+struct sgm_stereo_pair
+{
+    std::string name;
+    std::string left_path;
+    std::string right_path;
+    std::string gt_path;
+    double gt_scale;
+};
+
+/**
+ * @brief Pair resampled onto a processing grid that fits the engine maxima (aspect ratio preserved).
+ */
+struct sgm_loaded_pair
+{
+    int rows;
+    int cols;
+    sgm_image left;         // Grayscale, rows x cols
+    sgm_image right;        // Grayscale, rows x cols
+    sgm_image ground_truth; // Disparity in processing-grid pixels (0 = unknown); empty without ground truth
+};
+
+/**
+ * @brief Recursively collects all stereo pairs below @p root, sorted by name.
+ */
+bool sgm_scan_dataset(const std::string &root, std::vector<sgm_stereo_pair> &pairs, std::string &error);
+
+/**
+ * @brief Loads, converts to grayscale and downsamples a pair so that it fits max_cols x max_rows.
+ */
+bool sgm_load_pair(const sgm_stereo_pair &pair, int max_cols, int max_rows, sgm_loaded_pair &loaded, std::string &error);
+
+#endif
@@ -0,0 +1,52 @@
+#include "disparity_metrics.h"
+
+#include <cmath>
+
+/**
+ * @file disparity_metrics.cpp
+ * @brief Bad-pixel rates and RMSE against resampled ground truth.
+ */
+
+sgm_image sgm_prepare_ground_truth(const sgm_image &raw, int cols, int rows, double gt_scale)
+{
+    // Area-average valid samples only, then convert to disparities of the processing grid
+    sgm_image ground_truth = sgm_resize_area(sgm_to_gray(raw), cols, rows, true);
+    double disparity_scale = (double)cols / raw.width / gt_scale;
+    for (size_t i = 0; i < ground_truth.pixels.size(); i++)
+        ground_truth.pixels[i] = (float)(ground_truth.pixels[i] * disparity_scale);
+    return ground_truth;
+}
+
+sgm_disparity_metrics sgm_evaluate_disparity(const int *disparity, const sgm_image &ground_truth, int disp_range)
+{
+    sgm_disparity_metrics metrics = {0, 0.0, 0.0, 0.0, 0.0};
+    long bad1 = 0, bad2 = 0, in_range = 0, bad2_in_range = 0;
+    double squared_error = 0.0;
+
+    for (size_t i = 0; i < ground_truth.pixels.size(); i++)
+    {
+        double truth = ground_truth.pixels[i];
+        if (truth <= 0.0)
+            continue; // Unknown / occluded in the ground truth
+        double error = std::fabs((double)disparity[i] - truth);
+        metrics.valid_pixels++;
+        bad1 += (error > 1.0);
+        bad2 += (error > 2.0);
+        squared_error += error * error;
+        if (truth < disp_range)
+        {
+            in_range++;
+            bad2_in_range += (error > 2.0);
+        }
+    }
+
+    if (metrics.valid_pixels > 0)
+    {
+        metrics.bad1 = 100.0 * bad1 / metrics.valid_pixels;
+        metrics.bad2 = 100.0 * bad2 / metrics.valid_pixels;
+        metrics.rmse = std::sqrt(squared_error / metrics.valid_pixels);
+    }
+    if (in_range > 0)
+        metrics.bad2_in_range = 100.0 * bad2_in_range / in_range;
+    return metrics;
+}
@@ -0,0 +1,34 @@
+#ifndef SGM_DISPARITY_METRICS_H
+#define SGM_DISPARITY_METRICS_H
+
+#include "image_io.h"
+
+/**
+ * @file disparity_metrics.h
+ * @brief Ground-truth preparation and disparity error metrics shared by the evaluation tools.
+ */
+
+/**
+ * @brief Error statistics over pixels with known ground truth (ground truth > 0).
+ */
+struct sgm_disparity_metrics
+{
+    long valid_pixels;
+    double bad1;          // % of valid pixels with |d - gt| > 1
+    double bad2;          // % of valid pixels with |d - gt| > 2
+    double bad2_in_range; // Same, restricted to ground truth inside the disparity search range
+    double rmse;
+};
+
+/**
+ * @brief Resamples raw ground truth onto a rows x cols processing grid, in pixels of that grid.
+ * @param gt_scale  Stored intensity levels per pixel of disparity at ground-truth resolution.
+ */
+sgm_image sgm_prepare_ground_truth(const sgm_image &raw, int cols, int rows, double gt_scale);
+
+/**
+ * @brief Compares a dense disparity map with prepared ground truth of the same geometry.
+ */
+sgm_disparity_metrics sgm_evaluate_disparity(const int *disparity, const sgm_image &ground_truth, int disp_range);
+
+#endif
@@ -0,0 +1,541 @@
+#include "disparity_server.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @file disparity_server.cpp
+ * @brief Socket handling, buffer attachment, request batching and the worker pool of the disparity daemon.
+ */
+
+#define SGM_SERVER_BACKLOG 64
+#define SGM_SERVER_MAX_PASSED_FDS 4 // Control space per message; a valid request carries at most one fd
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool make_address(const std::string &socket_path, sockaddr_un &address, std::string &error)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+    {
+        error = "socket path \"" + socket_path + "\" is empty or too long";
+        return false;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+    return true;
+}
+
+static sgm_server_reply make_reply(uint64_t id, int32_t status)
+{
+    sgm_server_reply reply;
+    std::memset(&reply, 0, sizeof(reply));
+    reply.magic = SGM_SERVER_MAGIC;
+    reply.version = SGM_SERVER_VERSION;
+    reply.type = SGM_SERVER_RESULT;
+    reply.status = status;
+    reply.id = id;
+    return reply;
+}
+
+/**
+ * @brief Collects every descriptor passed with @p message (all SCM_RIGHTS headers, all fds in each).
+ * @return Number of descriptors stored in @p fds; the caller owns and must close each of them.
+ */
+static int passed_descriptors(msghdr &message, int fds[SGM_SERVER_MAX_PASSED_FDS])
+{
+    int count = 0;
+    for (cmsghdr *header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+            continue;
+        size_t payload = header->cmsg_len - CMSG_LEN(0);
+        for (size_t i = 0; i + sizeof(int) <= payload && count < SGM_SERVER_MAX_PASSED_FDS; i += sizeof(int))
+            std::memcpy(&fds[count++], CMSG_DATA(header) + i, sizeof(int));
+    }
+    return count;
+}
+
+/**
+ * @brief True if a plane of @p bytes at @p offset is aligned and lies inside a buffer of @p buffer_bytes.
+ */
+static bool plane_fits(uint64_t offset, uint64_t bytes, uint64_t alignment, uint64_t buffer_bytes)
+{
+    return offset % alignment == 0 && offset <= buffer_bytes && bytes <= buffer_bytes - offset;
+}
+
+/**
+ * @brief One client: its socket and attached buffer, kept alive by queued jobs after a disconnect.
+ */
+struct sgm_disparity_server::connection
+{
+    connection(int socket_fd) : fd(socket_fd), stalled(false), buffer(0), buffer_bytes(0) {}
+
+    ~connection()
+    {
+        if (buffer.load())
+            munmap(buffer.load(), buffer_bytes);
+        ::close(fd);
+    }
+
+    /**
+     * @brief Sends a reply without blocking (MSG_NOSIGNAL: a vanished client raises no SIGPIPE).
+     *
+     * A client that stops reading cannot stall a worker: once its socket buffer is full, the reply would
+     * block or be cut short, so the client is disconnected instead. shutdown() wakes the I/O thread, which
+     * drops the connection; no later reply is sent to it.
+     */
+    void send_reply(const sgm_server_reply &reply)
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        if (stalled)
+            return;
+        if (send(fd, &reply, sizeof(reply), MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)sizeof(reply))
+        {
+            stalled = true;
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    int fd;
+    std::mutex send_mutex;              // Workers reply concurrently
+    bool stalled;                       // A reply would have blocked; guarded by send_mutex
+    std::atomic<unsigned char *> buffer; // Published by the I/O thread after buffer_bytes
+    size_t buffer_bytes;
+};
+
+/**
+ * @brief Queued COMPUTE request.
+ */
+struct sgm_disparity_server::job
+{
+    std::shared_ptr<connection> client;
+    sgm_server_request request;
+    int64_t arrival_ns;
+};
+
+sgm_disparity_server::sgm_disparity_server()
+    : listen_fd(-1), max_batch(1), stopping(false), served(0), batches(0)
+{
+    wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+sgm_disparity_server::~sgm_disparity_server()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    for (size_t i = 0; i < workspaces.size(); i++)
+        sgm_destroy_workspace(workspaces[i]);
+    close_all();
+}
+
+void sgm_disparity_server::close_all()
+{
+    if (listen_fd >= 0)
+    {
+        ::close(listen_fd);
+        unlink(path.c_str());
+        listen_fd = -1;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        if (wake_pipe[i] >= 0)
+            ::close(wake_pipe[i]);
+        wake_pipe[i] = -1;
+    }
+}
+
+bool sgm_disparity_server::start(const std::string &socket_path, int worker_count, int batch_limit,
+                                 std::string &error)
+{
+    sockaddr_un address;
+    if (!make_address(socket_path, address, error))
+        return false;
+    path = socket_path;
+    max_batch = (batch_limit > 0) ? batch_limit : 1;
+
+    if (pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) != 0)
+    {
+        error = std::string("pipe2 failed: ") + std::strerror(errno);
+        return false;
+    }
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+    {
+        error = std::string("socket failed: ") + std::strerror(errno);
+        return false;
+    }
+    unlink(path.c_str()); // Stale socket file from a crashed daemon
+    if (bind(listen_fd, (const sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, SGM_SERVER_BACKLOG) != 0)
+    {
+        error = "cannot listen on " + path + ": " + std::strerror(errno);
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    // Workspaces are created once here; a request only adds the buffers of a mode not served before
+    for (int w = 0; w < ((worker_count > 0) ? worker_count : 1); w++)
+    {
+        sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+        if (!workspace)
+        {
+            error = "cannot allocate worker workspaces";
+            return false;
+        }
+        workspaces.push_back(workspace);
+    }
+    for (size_t w = 0; w < workspaces.size(); w++)
+        workers.push_back(std::thread(&sgm_disparity_server::worker_loop, this, workspaces[w]));
+    return true;
+}
+
+void sgm_disparity_server::request_stop()
+{
+    char byte = 1;
+    if (wake_pipe[1] >= 0)
+        (void)!write(wake_pipe[1], &byte, 1);
+}
+
+void sgm_disparity_server::statistics(uint64_t &requests, uint64_t &batch_count) const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    requests = served;
+    batch_count = batches;
+}
+
+bool sgm_disparity_server::receive(const std::shared_ptr<connection> &client, std::vector<job> &batch)
+{
+    for (;;)
+    {
+        sgm_server_request request;
+        union
+        {
+            char bytes[CMSG_SPACE(SGM_SERVER_MAX_PASSED_FDS * sizeof(int))];
+            cmsghdr align;
+        } control;
+        iovec vector = {&request, sizeof(request)};
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control.bytes;
+        message.msg_controllen = sizeof(control.bytes);
+
+        ssize_t bytes = recvmsg(client->fd, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        if (bytes < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        if (bytes == 0)
+            return false;
+
+        // Every received descriptor is ours to close. A truncated message or control block, or more than
+        // one descriptor, fails the request; MSG_CTRUNC means the kernel already dropped fds it could not fit.
+        int fds[SGM_SERVER_MAX_PASSED_FDS];
+        int fd_count = passed_descriptors(message, fds);
+        int passed_fd = (fd_count == 1) ? fds[0] : -1;
+        for (int i = (fd_count == 1) ? 1 : 0; i < fd_count; i++)
+            ::close(fds[i]);
+
+        bool valid = bytes == (ssize_t)sizeof(request) && !(message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) &&
+                     fd_count <= 1 && request.magic == SGM_SERVER_MAGIC && request.version == SGM_SERVER_VERSION;
+        if (valid && request.type == SGM_SERVER_COMPUTE && fd_count == 0)
+        {
+            job item;
+            item.client = client;
+            item.request = request;
+            item.arrival_ns = now_ns();
+            batch.push_back(item);
+            continue;
+        }
+
+        // ATTACH is answered here: one buffer per connection, mapped for the connection's lifetime. The
+        // object behind the fd must cover the claimed size, or touching a plane past its end raises SIGBUS.
+        int32_t status = SGM_SERVER_ERROR_REQUEST;
+        if (valid && request.type == SGM_SERVER_ATTACH && passed_fd >= 0 && !client->buffer.load() &&
+            request.buffer_bytes > 0)
+        {
+            struct stat info;
+            void *base = MAP_FAILED;
+            if (fstat(passed_fd, &info) == 0 && info.st_size >= 0 && (uint64_t)info.st_size >= request.buffer_bytes)
+                base = mmap(0, request.buffer_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, passed_fd, 0);
+            if (base == MAP_FAILED)
+                status = SGM_SERVER_ERROR_ATTACH;
+            else
+            {
+                client->buffer_bytes = request.buffer_bytes;
+                client->buffer.store((unsigned char *)base, std::memory_order_release);
+                status = SGM_SERVER_OK;
+            }
+        }
+        if (passed_fd >= 0)
+            ::close(passed_fd);
+        client->send_reply(make_reply(valid ? request.id : 0, status));
+    }
+}
+
+void sgm_disparity_server::run()
+{
+    std::vector<std::shared_ptr<connection> > clients;
+    std::vector<pollfd> descriptors;
+
+    for (;;)
+    {
+        descriptors.resize(2 + clients.size());
+        descriptors[0].fd = wake_pipe[0];
+        descriptors[1].fd = listen_fd;
+        for (size_t i = 0; i < clients.size(); i++)
+            descriptors[2 + i].fd = clients[i]->fd;
+        for (size_t i = 0; i < descriptors.size(); i++)
+        {
+            descriptors[i].events = POLLIN;
+            descriptors[i].revents = 0;
+        }
+
+        if (poll(&descriptors[0], descriptors.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (descriptors[0].revents)
+            break;
+
+        // Every request that arrived in this round forms one batch for the pool
+        std::vector<job> batch;
+        std::vector<std::shared_ptr<connection> > open_clients;
+        for (size_t i = 0; i < clients.size(); i++)
+        {
+            if (!descriptors[2 + i].revents || receive(clients[i], batch))
+                open_clients.push_back(clients[i]);
+        }
+        clients.swap(open_clients);
+
+        if (descriptors[1].revents & POLLIN)
+        {
+            int fd = accept4(listen_fd, 0, 0, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0)
+                clients.push_back(std::make_shared<connection>(fd));
+        }
+
+        if (!batch.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                queue.insert(queue.end(), batch.begin(), batch.end());
+            }
+            queue_ready.notify_all();
+        }
+    }
+
+    // Finish queued work; clients that are still connected receive their replies
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+    close_all();
+}
+
+void sgm_disparity_server::worker_loop(sgm_workspace_t *workspace)
+{
+    std::vector<job> taken;
+    for (;;)
+    {
+        taken.clear();
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (queue.empty())
+                return;
+            while (!queue.empty() && (int)taken.size() < max_batch)
+            {
+                taken.push_back(queue.front());
+                queue.pop_front();
+            }
+            served += taken.size();
+            batches++;
+        }
+
+        for (size_t i = 0; i < taken.size(); i++)
+        {
+            const sgm_server_request &request = taken[i].request;
+            connection &client = *taken[i].client;
+            unsigned char *buffer = client.buffer.load(std::memory_order_acquire);
+            sgm_server_reply reply = make_reply(request.id, SGM_SERVER_OK);
+            reply.batch_size = (uint32_t)taken.size();
+
+            uint64_t plane_pixels = (uint64_t)request.config.rows * request.config.cols;
+            if (sgm_check_config(request.config) != 0)
+                reply.status = SGM_SERVER_ERROR_CONFIG;
+            else if (!buffer ||
+                     !plane_fits(request.left_offset, plane_pixels * sizeof(float), sizeof(float), client.buffer_bytes) ||
+                     !plane_fits(request.right_offset, plane_pixels * sizeof(float), sizeof(float), client.buffer_bytes) ||
+                     !plane_fits(request.disparity_offset, plane_pixels * sizeof(int), sizeof(int), client.buffer_bytes))
+                reply.status = SGM_SERVER_ERROR_REQUEST;
+            else if (sgm_reserve_workspace(*workspace, request.config) != 0)
+                reply.status = SGM_SERVER_ERROR_MEMORY;
+            else
+            {
+                int64_t start_ns = now_ns();
+                reply.queue_ns = start_ns - taken[i].arrival_ns;
+                sgm_compute(request.config, (const float *)(buffer + request.left_offset),
+                            (const float *)(buffer + request.right_offset),
+                            (int *)(buffer + request.disparity_offset), *workspace);
+                reply.compute_ns = now_ns() - start_ns;
+            }
+            client.send_reply(reply);
+        }
+    }
+}
+
+sgm_disparity_client::sgm_disparity_client() : socket_fd(-1), buffer(0), buffer_bytes(0)
+{
+}
+
+sgm_disparity_client::~sgm_disparity_client()
+{
+    close();
+}
+
+void sgm_disparity_client::close()
+{
+    if (buffer)
+        munmap(buffer, buffer_bytes);
+    if (socket_fd >= 0)
+        ::close(socket_fd);
+    buffer = 0;
+    buffer_bytes = 0;
+    socket_fd = -1;
+}
+
+bool sgm_disparity_client::connect(const std::string &socket_path, std::string &error)
+{
+    close();
+    sockaddr_un address;
+    if (!make_address(socket_path, address, error))
+        return false;
+    socket_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (socket_fd < 0 || ::connect(socket_fd, (const sockaddr *)&address, sizeof(address)) != 0)
+    {
+        error = "cannot connect to " + socket_path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void *sgm_disparity_client::attach(size_t bytes, std::string &error)
+{
+    static std::atomic<unsigned> counter(0);
+    std::string name = "/sgm_client_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+
+    // Named only until it is mapped: the descriptor passed to the server keeps the object alive
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        error = "shm_open failed for " + name + ": " + std::strerror(errno);
+        return 0;
+    }
+    shm_unlink(name.c_str());
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)bytes) == 0)
+        base = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        error = "cannot map a " + std::to_string(bytes) + "-byte client buffer: " + std::strerror(errno);
+        ::close(fd);
+        return 0;
+    }
+
+    sgm_server_request request;
+    std::memset(&request, 0, sizeof(request));
+    request.magic = SGM_SERVER_MAGIC;
+    request.version = SGM_SERVER_VERSION;
+    request.type = SGM_SERVER_ATTACH;
+    request.buffer_bytes = bytes;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+    iovec vector = {&request, sizeof(request)};
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+
+    bool sent = sendmsg(socket_fd, &message, MSG_NOSIGNAL) == (ssize_t)sizeof(request);
+    ::close(fd);
+    sgm_server_reply reply;
+    if (!sent || !receive(reply, error) || reply.status != SGM_SERVER_OK)
+    {
+        if (error.empty())
+            error = "server rejected the shared buffer";
+        munmap(base, bytes);
+        return 0;
+    }
+    buffer = base;
+    buffer_bytes = bytes;
+    return base;
+}
+
+bool sgm_disparity_client::submit(uint64_t id, const sgm_config_t &config, uint64_t left_offset,
+                                  uint64_t right_offset, uint64_t disparity_offset, std::string &error)
+{
+    sgm_server_request request;
+    std::memset(&request, 0, sizeof(request));
+    request.magic = SGM_SERVER_MAGIC;
+    request.version = SGM_SERVER_VERSION;
+    request.type = SGM_SERVER_COMPUTE;
+    request.id = id;
+    request.left_offset = left_offset;
+    request.right_offset = right_offset;
+    request.disparity_offset = disparity_offset;
+    request.config = config;
+    if (send(socket_fd, &request, sizeof(request), MSG_NOSIGNAL) != (ssize_t)sizeof(request))
+    {
+        error = std::string("request send failed: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool sgm_disparity_client::receive(sgm_server_reply &reply, std::string &error)
+{
+    ssize_t bytes;
+    do
+        bytes = recv(socket_fd, &reply, sizeof(reply), 0);
+    while (bytes < 0 && errno == EINTR);
+    if (bytes != (ssize_t)sizeof(reply) || reply.magic != SGM_SERVER_MAGIC || reply.type != SGM_SERVER_RESULT)
+    {
+        error = (bytes == 0) ? "server closed the connection" : "malformed server reply";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+#ifndef SGM_DISPARITY_SERVER_H
+#define SGM_DISPARITY_SERVER_H
+
+#include "sgm_hls.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file disparity_server.h
+ * @brief Local disparity daemon: stereo pairs over a Unix-domain socket, pixels in shared memory.
+ *
+ * A client creates an anonymous shared-memory buffer and passes its file descriptor to the server once
+ * (SGM_SERVER_ATTACH, SCM_RIGHTS). Requests then carry only offsets into that buffer: the server reads
+ * the left / right planes in place and writes the disparity plane back into it, so no pixel crosses the
+ * socket. Messages are fixed-size records on a SOCK_SEQPACKET socket.
+ *
+ * One I/O thread polls the listening socket and every client, gathers all requests that arrived in a
+ * poll round and hands them to the worker pool as one batch (a single lock and wake-up). Each worker
+ * owns a workspace created at startup and takes up to max_batch queued requests at a time, runs them
+ * back to back and replies on the client's socket. The workspace keeps the buffers reserved for the modes
+ * of earlier requests, so engine startup and workspace allocation are paid once per daemon and mode, not
+ * per client.
+ */
+
+#define SGM_SERVER_MAGIC 0x53474d44u // "SGMD"
+#define SGM_SERVER_VERSION 1
+#define SGM_SERVER_ALIGN 64          // Suggested plane alignment inside client buffers
+
+/* --- Message types --- */
+#define SGM_SERVER_ATTACH 1  // Request: shared-memory buffer (fd in SCM_RIGHTS) of buffer_bytes
+#define SGM_SERVER_COMPUTE 2 // Request: disparity of the pair at left_offset / right_offset
+#define SGM_SERVER_RESULT 3  // Reply to ATTACH or COMPUTE
+
+/* --- Reply status --- */
+#define SGM_SERVER_OK 0
+#define SGM_SERVER_ERROR_REQUEST -1 // Malformed message, no attached buffer, or planes outside the buffer
+#define SGM_SERVER_ERROR_CONFIG -2  // sgm_check_config rejected the request configuration
+#define SGM_SERVER_ERROR_ATTACH -3  // Buffer could not be mapped
+#define SGM_SERVER_ERROR_MEMORY -4  // Workspace buffers of the request configuration could not be allocated
+
+/**
+ * @brief Client -> server record.
+ */
+struct sgm_server_request
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t id;               // Echoed in the reply
+    uint64_t buffer_bytes;     // ATTACH: size of the shared-memory buffer
+    uint64_t left_offset;      // COMPUTE: packed float planes of config.rows x config.cols
+    uint64_t right_offset;
+    uint64_t disparity_offset; // COMPUTE: packed int plane written by the server
+    sgm_config_t config;
+};
+
+/**
+ * @brief Server -> client record.
+ */
+struct sgm_server_reply
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t type;
+    int32_t status;      // SGM_SERVER_OK or SGM_SERVER_ERROR_*
+    uint64_t id;
+    int64_t queue_ns;    // Arrival to start of computation
+    int64_t compute_ns;
+    uint32_t batch_size; // Requests the worker took together with this one
+    uint32_t reserved;
+};
+
+/**
+ * @brief The daemon: listening socket, I/O thread and worker pool.
+ */
+class sgm_disparity_server
+{
+public:
+    sgm_disparity_server();
+    ~sgm_disparity_server();
+
+    /**
+     * @brief Binds @p socket_path (replacing a stale socket file) and creates one workspace per worker.
+     */
+    bool start(const std::string &socket_path, int workers, int max_batch, std::string &error);
+
+    /** @brief Serves clients until request_stop(); then drains queued requests and joins the workers. */
+    void run();
+
+    /** @brief Async-signal-safe: wakes run() and makes it return. */
+    void request_stop();
+
+    /** @brief Requests served and worker batches taken so far. */
+    void statistics(uint64_t &requests, uint64_t &batches) const;
+
+private:
+    struct connection;
+    struct job;
+
+    sgm_disparity_server(const sgm_disparity_server &);
+    sgm_disparity_server &operator=(const sgm_disparity_server &);
+
+    void worker_loop(sgm_workspace_t *workspace);
+    bool receive(const std::shared_ptr<connection> &client, std::vector<job> &batch);
+    void close_all();
+
+    std::string path;
+    int listen_fd;
+    int wake_pipe[2];
+    int max_batch;
+    std::vector<sgm_workspace_t *> workspaces;
+    std::vector<std::thread> workers;
+
+    mutable std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<job> queue;
+    bool stopping;
+    uint64_t served;
+    uint64_t batches;
+};
+
+/**
+ * @brief Client side: connection, shared buffer and request / reply helpers.
+ */
+class sgm_disparity_client
+{
+public:
+    sgm_disparity_client();
+    ~sgm_disparity_client();
+
+    bool connect(const std::string &socket_path, std::string &error);
+
+    /**
+     * @brief Creates an anonymous shared-memory buffer of @p bytes, maps it and registers it with the server.
+     * @return Base address of the buffer (planes are addressed by offset from it), or 0.
+     */
+    void *attach(size_t bytes, std::string &error);
+
+    /** @brief Queues a disparity request; several may be in flight. */
+    bool submit(uint64_t id, const sgm_config_t &config, uint64_t left_offset, uint64_t right_offset,
+                uint64_t disparity_offset, std::string &error);
+
+    /** @brief Blocks for the next reply (replies may arrive out of submission order). */
+    bool receive(sgm_server_reply &reply, std::string &error);
+
+    void close();
+
+private:
+    sgm_disparity_client(const sgm_disparity_client &);
+    sgm_disparity_client &operator=(const sgm_disparity_client &);
+
+    int socket_fd;
+    void *buffer;
+    size_t buffer_bytes;
+};
+
+#endif
@@ -0,0 +1,546 @@
+#include "image_io.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+
+/**
+ * @file image_io.cpp
+ * @brief PNG decoding/encoding (zlib), PFM and pixel-stream loading, resampling, disparity output.
+ */
+
+static unsigned int read_be32(const unsigned char *bytes)
+{
+    return ((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) |
+           ((unsigned int)bytes[2] << 8) | (unsigned int)bytes[3];
+}
+
+/**
+ * @brief Paeth predictor as defined by the PNG specification (filter type 4).
+ */
+static int paeth_predictor(int left, int up, int up_left)
+{
+    int estimate = left + up - up_left;
+    int dist_left = std::abs(estimate - left);
+    int dist_up = std::abs(estimate - up);
+    int dist_up_left = std::abs(estimate - up_left);
+    if (dist_left <= dist_up && dist_left <= dist_up_left)
+        return left;
+    if (dist_up <= dist_up_left)
+        return up;
+    return up_left;
+}
+
+bool sgm_read_png(const std::string &path, sgm_image &image, std::string &error)
+{
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::ifstream stream(path.c_str(), std::ios::binary);
+    if (!stream.is_open())
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    if (file.size() < 8 || !std::equal(signature, signature + 8, file.begin()))
+    {
+        error = path + " is not a PNG file";
+        return false;
+    }
+
+    // Walk the chunk list: IHDR for geometry, concatenated IDAT for the zlib stream
+    int width = 0, height = 0, bit_depth = 0, color_type = -1, interlace = 0;
+    std::vector<unsigned char> compressed;
+    size_t offset = 8;
+    while (offset + 12 <= file.size())
+    {
+        unsigned int length = read_be32(&file[offset]);
+        std::string type(file.begin() + offset + 4, file.begin() + offset + 8);
+        const unsigned char *data = &file[offset + 8];
+        if (offset + 12 + length > file.size())
+            break;
+
+        if (type == "IHDR" && length >= 13)
+        {
+            width = (int)read_be32(data);
+            height = (int)read_be32(data + 4);
+            bit_depth = data[8];
+            color_type = data[9];
+            interlace = data[12];
+        }
+        else if (type == "IDAT")
+            compressed.insert(compressed.end(), data, data + length);
+        else if (type == "IEND")
+            break;
+        offset += 12 + length;
+    }
+
+    int channels = 0;
+    switch (color_type)
+    {
+    case 0: channels = 1; break; // Grayscale
+    case 2: channels = 3; break; // RGB
+    case 4: channels = 2; break; // Grayscale + alpha
+    case 6: channels = 4; break; // RGBA
+    default:
+        error = path + ": unsupported PNG color type (palette or missing IHDR)";
+        return false;
+    }
+    if ((bit_depth != 8 && bit_depth != 16) || interlace != 0 || width <= 0 || height <= 0)
+    {
+        error = path + ": only non-interlaced 8/16-bit PNG is supported";
+        return false;
+    }
+    // Header values are untrusted: bound them before sizing the inflate buffer
+    if (width > SGM_IMAGE_MAX_DIMENSION || height > SGM_IMAGE_MAX_DIMENSION)
+    {
+        error = path + ": PNG larger than " + std::to_string(SGM_IMAGE_MAX_DIMENSION) + " pixels per side";
+        return false;
+    }
+    if (compressed.empty())
+    {
+        error = path + ": PNG has no image data (IDAT)";
+        return false;
+    }
+
+    // Inflate: every scanline is prefixed with its filter type byte
+    int bytes_per_pixel = channels * bit_depth / 8;
+    size_t row_bytes = (size_t)width * bytes_per_pixel;
+    if ((row_bytes + 1) * height > (size_t)(uLongf)-1)
+    {
+        error = path + ": PNG image data too large to inflate";
+        return false;
+    }
+    uLongf raw_size = (uLongf)((row_bytes + 1) * height);
+    std::vector<unsigned char> raw(raw_size);
+    if (uncompress(&raw[0], &raw_size, &compressed[0], (uLong)compressed.size()) != Z_OK ||
+        raw_size != (uLongf)((row_bytes + 1) * height))
+    {
+        error = path + ": corrupt PNG image data";
+        return false;
+    }
+
+    // Undo the per-scanline prediction filters in place
+    std::vector<unsigned char> previous(row_bytes, 0);
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char filter = raw[y * (row_bytes + 1)];
+        unsigned char *row = &raw[y * (row_bytes + 1) + 1];
+        for (size_t i = 0; i < row_bytes; i++)
+        {
+            int left = (i >= (size_t)bytes_per_pixel) ? row[i - bytes_per_pixel] : 0;
+            int up = previous[i];
+            int up_left = (i >= (size_t)bytes_per_pixel) ? previous[i - bytes_per_pixel] : 0;
+            switch (filter)
+            {
+            case 0: break;
+            case 1: row[i] = (unsigned char)(row[i] + left); break;
+            case 2: row[i] = (unsigned char)(row[i] + up); break;
+            case 3: row[i] = (unsigned char)(row[i] + ((left + up) >> 1)); break;
+            case 4: row[i] = (unsigned char)(row[i] + paeth_predictor(left, up, up_left)); break;
+            default:
+                error = path + ": invalid PNG filter type";
+                return false;
+            }
+        }
+        previous.assign(row, row + row_bytes);
+    }
+
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize((size_t)width * height * channels);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *row = &raw[y * (row_bytes + 1) + 1];
+        for (int i = 0; i < width * channels; i++)
+        {
+            image.pixels[(size_t)y * width * channels + i] =
+                (bit_depth == 16) ? (float)((row[2 * i] << 8) | row[2 * i + 1]) : (float)row[i];
+        }
+    }
+    return true;
+}
+
+static bool host_little_endian()
+{
+    const unsigned int probe = 1;
+    return *reinterpret_cast<const unsigned char *>(&probe) == 1;
+}
+
+bool sgm_read_pfm(const std::string &path, sgm_image &image, std::string &error)
+{
+    std::ifstream stream(path.c_str(), std::ios::binary);
+    if (!stream.is_open())
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string magic;
+    int width = 0, height = 0;
+    double scale = 0.0;
+    stream >> magic >> width >> height >> scale;
+    stream.get(); // Single whitespace byte terminates the header
+
+    int channels = (magic == "PF") ? 3 : (magic == "Pf") ? 1 : 0;
+    if (channels == 0 || width <= 0 || height <= 0 || width > SGM_IMAGE_MAX_DIMENSION ||
+        height > SGM_IMAGE_MAX_DIMENSION || !stream)
+    {
+        error = path + " is not a PFM file";
+        return false;
+    }
+
+    std::vector<float> raw((size_t)width * height * channels);
+    stream.read(reinterpret_cast<char *>(&raw[0]), (std::streamsize)(raw.size() * sizeof(float)));
+    if (stream.gcount() != (std::streamsize)(raw.size() * sizeof(float)))
+    {
+        error = path + ": truncated PFM data";
+        return false;
+    }
+
+    // Negative scale marks little-endian samples; swap when the host order differs
+    if ((scale < 0.0) != host_little_endian())
+    {
+        for (size_t i = 0; i < raw.size(); i++)
+        {
+            unsigned char *bytes = reinterpret_cast<unsigned char *>(&raw[i]);
+            std::swap(bytes[0], bytes[3]);
+            std::swap(bytes[1], bytes[2]);
+        }
+    }
+
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize(raw.size());
+    size_t row_samples = (size_t)width * channels;
+    for (int y = 0; y < height; y++)
+    {
+        const float *source = &raw[(size_t)(height - 1 - y) * row_samples];
+        float *target = &image.pixels[(size_t)y * row_samples];
+        for (size_t i = 0; i < row_samples; i++)
+            target[i] = std::isfinite(source[i]) ? source[i] : 0.0f;
+    }
+    return true;
+}
+
+bool sgm_read_image(const std::string &path, sgm_image &image, std::string &error)
+{
+    size_t dot = path.find_last_of('.');
+    std::string extension = (dot == std::string::npos) ? std::string() : path.substr(dot + 1);
+    for (size_t i = 0; i < extension.size(); i++)
+        extension[i] = (char)std::tolower((unsigned char)extension[i]);
+
+    if (extension == "pfm")
+        return sgm_read_pfm(path, image, error);
+    if (extension == "png")
+        return sgm_read_png(path, image, error);
+    error = path + ": unsupported image format (expected .png or .pfm)";
+    return false;
+}
+
+bool sgm_read_pixel_text(const std::string &path, int width, int height, sgm_image &image, std::string &error)
+{
+    std::ifstream stream(path.c_str());
+    if (!stream.is_open())
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    image.width = width;
+    image.height = height;
+    image.channels = 1;
+    image.pixels.resize((size_t)width * height);
+    for (size_t i = 0; i < image.pixels.size(); i++)
+    {
+        if (!(stream >> image.pixels[i]))
+        {
+            error = path + ": pixel stream shorter than the requested geometry";
+            return false;
+        }
+    }
+    return true;
+}
+
+sgm_image sgm_to_gray(const sgm_image &image)
+{
+    if (image.channels == 1)
+        return image;
+
+    sgm_image gray;
+    gray.width = image.width;
+    gray.height = image.height;
+    gray.channels = 1;
+    gray.pixels.resize((size_t)image.width * image.height);
+    for (size_t i = 0; i < gray.pixels.size(); i++)
+    {
+        const float *sample = &image.pixels[i * image.channels];
+        gray.pixels[i] = (image.channels >= 3) ? 0.299f * sample[0] + 0.587f * sample[1] + 0.114f * sample[2]
+                                               : sample[0];
+    }
+    return gray;
+}
+
+sgm_image sgm_resize_area(const sgm_image &image, int width, int height, bool ignore_zero)
+{
+    sgm_image resized;
+    resized.width = width;
+    resized.height = height;
+    resized.channels = image.channels;
+    resized.pixels.assign((size_t)width * height * image.channels, 0.0f);
+
+    for (int ty = 0; ty < height; ty++)
+    {
+        // Source footprint of the target row/column; at least one sample when upscaling
+        int y0 = (int)((long long)ty * image.height / height);
+        int y1 = (int)((long long)(ty + 1) * image.height / height);
+        if (y1 <= y0)
+            y1 = y0 + 1;
+
+        for (int tx = 0; tx < width; tx++)
+        {
+            int x0 = (int)((long long)tx * image.width / width);
+            int x1 = (int)((long long)(tx + 1) * image.width / width);
+            if (x1 <= x0)
+                x1 = x0 + 1;
+
+            for (int c = 0; c < image.channels; c++)
+            {
+                double sum = 0.0;
+                int count = 0;
+                for (int y = y0; y < y1; y++)
+                {
+                    for (int x = x0; x < x1; x++)
+                    {
+                        float sample = image.pixels[((size_t)y * image.width + x) * image.channels + c];
+                        if (ignore_zero && sample == 0.0f)
+                            continue;
+                        sum += sample;
+                        count++;
+                    }
+                }
+                resized.pixels[((size_t)ty * width + tx) * image.channels + c] =
+                    (count > 0) ? (float)(sum / count) : 0.0f;
+            }
+        }
+    }
+    return resized;
+}
+
+void sgm_to_rgb8(const sgm_image &image, std::vector<unsigned char> &rgb)
+{
+    size_t count = (size_t)image.width * image.height;
+    rgb.resize(count * 3);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float *sample = &image.pixels[i * image.channels];
+        for (int c = 0; c < 3; c++)
+        {
+            float value = (image.channels >= 3) ? sample[c] : sample[0];
+            value = (value < 0.0f) ? 0.0f : (value > 255.0f) ? 255.0f : value;
+            rgb[i * 3 + c] = (unsigned char)(value + 0.5f);
+        }
+    }
+}
+
+bool sgm_parse_disparity_format(const std::string &name, sgm_disparity_format &format)
+{
+    static const struct
+    {
+        const char *name;
+        sgm_disparity_format format;
+    } formats[] = {{"txt", SGM_FORMAT_TEXT}, {"raw8", SGM_FORMAT_RAW8}, {"raw16", SGM_FORMAT_RAW16},
+                   {"pfm", SGM_FORMAT_PFM}, {"png16", SGM_FORMAT_PNG16}};
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        if (name == formats[i].name)
+        {
+            format = formats[i].format;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void append_be32(std::vector<unsigned char> &buffer, unsigned int value)
+{
+    buffer.push_back((unsigned char)(value >> 24));
+    buffer.push_back((unsigned char)(value >> 16));
+    buffer.push_back((unsigned char)(value >> 8));
+    buffer.push_back((unsigned char)value);
+}
+
+/**
+ * @brief Appends a PNG chunk (length, type, payload, CRC over type + payload).
+ */
+static void append_png_chunk(std::vector<unsigned char> &buffer, const char *type,
+                             const unsigned char *data, size_t length)
+{
+    append_be32(buffer, (unsigned int)length);
+    size_t type_offset = buffer.size();
+    buffer.insert(buffer.end(), type, type + 4);
+    if (length > 0)
+        buffer.insert(buffer.end(), data, data + length);
+    uLong crc = crc32(0L, &buffer[type_offset], (uInt)(4 + length));
+    append_be32(buffer, (unsigned int)crc);
+}
+
+static unsigned int clamp_sample(long value, unsigned int max_value)
+{
+    if (value < 0)
+        return 0;
+    return (value > (long)max_value) ? max_value : (unsigned int)value;
+}
+
+/**
+ * @brief Formats values as decimal lines without iostream overhead.
+ */
+static void encode_text(std::vector<unsigned char> &buffer, const int *disparity, size_t count)
+{
+    buffer.reserve(count * 4);
+    char digits[12];
+    for (size_t i = 0; i < count; i++)
+    {
+        long value = disparity[i];
+        bool negative = value < 0;
+        unsigned long magnitude = negative ? (unsigned long)(-value) : (unsigned long)value;
+        int length = 0;
+        do
+        {
+            digits[length++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (negative)
+            buffer.push_back('-');
+        while (length > 0)
+            buffer.push_back((unsigned char)digits[--length]);
+        buffer.push_back('\n');
+    }
+}
+
+static bool encode_png16(std::vector<unsigned char> &buffer, const int *disparity, int width, int height,
+                         int scale, std::string &error)
+{
+    // Filter type 0 per scanline, big-endian samples; fast deflate level keeps encoding cheap
+    size_t row_bytes = (size_t)width * 2;
+    std::vector<unsigned char> raw((row_bytes + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char *row = &raw[y * (row_bytes + 1)];
+        row[0] = 0;
+        for (int x = 0; x < width; x++)
+        {
+            unsigned int sample = clamp_sample((long)disparity[y * width + x] * scale, 65535);
+            row[1 + 2 * x] = (unsigned char)(sample >> 8);
+            row[2 + 2 * x] = (unsigned char)sample;
+        }
+    }
+
+    uLongf compressed_size = compressBound((uLong)raw.size());
+    std::vector<unsigned char> compressed(compressed_size);
+    if (compress2(&compressed[0], &compressed_size, &raw[0], (uLong)raw.size(), Z_BEST_SPEED) != Z_OK)
+    {
+        error = "PNG compression failed";
+        return false;
+    }
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    unsigned char header[13];
+    header[0] = (unsigned char)(width >> 24);
+    header[1] = (unsigned char)(width >> 16);
+    header[2] = (unsigned char)(width >> 8);
+    header[3] = (unsigned char)width;
+    header[4] = (unsigned char)(height >> 24);
+    header[5] = (unsigned char)(height >> 16);
+    header[6] = (unsigned char)(height >> 8);
+    header[7] = (unsigned char)height;
+    header[8] = 16; // Bit depth
+    header[9] = 0;  // Grayscale
+    header[10] = header[11] = header[12] = 0;
+
+    buffer.assign(signature, signature + 8);
+    append_png_chunk(buffer, "IHDR", header, sizeof(header));
+    append_png_chunk(buffer, "IDAT", &compressed[0], compressed_size);
+    append_png_chunk(buffer, "IEND", 0, 0);
+    return true;
+}
+
+bool sgm_write_disparity(const std::string &path, const int *disparity, int width, int height,
+                         sgm_disparity_format format, int scale, std::string &error)
+{
+    size_t count = (size_t)width * height;
+    std::vector<unsigned char> buffer;
+
+    switch (format)
+    {
+    case SGM_FORMAT_TEXT:
+        encode_text(buffer, disparity, count);
+        break;
+    case SGM_FORMAT_RAW8:
+        buffer.resize(count);
+        for (size_t i = 0; i < count; i++)
+            buffer[i] = (unsigned char)clamp_sample((long)disparity[i] * scale, 255);
+        break;
+    case SGM_FORMAT_RAW16:
+        buffer.resize(count * 2);
+        for (size_t i = 0; i < count; i++)
+        {
+            unsigned int sample = clamp_sample((long)disparity[i] * scale, 65535);
+            buffer[2 * i] = (unsigned char)sample;
+            buffer[2 * i + 1] = (unsigned char)(sample >> 8);
+        }
+        break;
+    case SGM_FORMAT_PFM:
+    {
+        // Rows are stored bottom-to-top; floats are written in host order, declared by the sign of the scale
+        // (negative: little-endian)
+        char header[64];
+        int header_length = std::snprintf(header, sizeof(header), "Pf\n%d %d\n%s\n", width, height,
+                                          host_little_endian() ? "-1.0" : "1.0");
+        buffer.assign(header, header + header_length);
+        buffer.resize(header_length + count * sizeof(float));
+        float *samples = reinterpret_cast<float *>(&buffer[header_length]);
+        for (int y = 0; y < height; y++)
+        {
+            const int *source = &disparity[(size_t)(height - 1 - y) * width];
+            for (int x = 0; x < width; x++)
+            {
+                float value = (float)source[x];
+                std::memcpy(&samples[(size_t)y * width + x], &value, sizeof(float));
+            }
+        }
+        break;
+    }
+    case SGM_FORMAT_PNG16:
+        if (!encode_png16(buffer, disparity, width, height, scale, error))
+            return false;
+        break;
+    default:
+        error = "unknown disparity output format";
+        return false;
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+    size_t written = buffer.empty() ? 0 : std::fwrite(&buffer[0], 1, buffer.size(), file);
+    bool closed = std::fclose(file) == 0;
+    if (written != buffer.size() || !closed)
+    {
+        error = "short write to " + path;
+        return false;
+    }
+    return true;
+}
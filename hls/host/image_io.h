@@ -0,0 +1,92 @@
+#ifndef SGM_IMAGE_IO_H
+#define SGM_IMAGE_IO_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @file image_io.h
+ * @brief Host-side image loading, resampling and disparity output used by the testbenches and tools.
+ *
+ * Images are kept as interleaved float samples holding the raw stored values (0..255 for 8-bit,
+ * 0..65535 for 16-bit), so disparity ground truth keeps its on-disk scale.
+ * All loaders and writers return false and fill @p error instead of throwing.
+ */
+
+#define SGM_IMAGE_MAX_DIMENSION 32768 // Largest width / height accepted from an image header
+
+/* --- Disparity Output Formats --- */
+enum sgm_disparity_format
+{
+    SGM_FORMAT_TEXT = 0, // One decimal value per line (notebook / RTL comparison format)
+    SGM_FORMAT_RAW8,     // Headerless uint8, row-major (values saturate at 255)
+    SGM_FORMAT_RAW16,    // Headerless little-endian uint16, row-major
+    SGM_FORMAT_PFM,      // Portable Float Map, single channel, host byte order
+    SGM_FORMAT_PNG16     // 16-bit grayscale PNG
+};
+
+/**
+ * @brief Decoded image with interleaved channels.
+ */
+struct sgm_image
+{
+    int width;
+    int height;
+    int channels;
+    std::vector<float> pixels; // width * height * channels samples, row-major
+};
+
+/**
+ * @brief Reads a non-interlaced PNG (gray, gray+alpha, RGB, RGBA; 8 or 16 bit).
+ * Files without image data or with a side above SGM_IMAGE_MAX_DIMENSION are rejected.
+ */
+bool sgm_read_png(const std::string &path, sgm_image &image, std::string &error);
+
+/**
+ * @brief Reads a Portable Float Map (Pf gray / PF color), flipping rows to top-down order.
+ * Non-finite samples (Middlebury marks unknown disparity with +inf) are stored as 0.
+ */
+bool sgm_read_pfm(const std::string &path, sgm_image &image, std::string &error);
+
+/**
+ * @brief Dispatches to the PNG or PFM reader based on the file extension.
+ */
+bool sgm_read_image(const std::string &path, sgm_image &image, std::string &error);
+
+/**
+ * @brief Reads the testbench pixel-stream format (one decimal sample per line, row-major).
+ */
+bool sgm_read_pixel_text(const std::string &path, int width, int height, sgm_image &image, std::string &error);
+
+/**
+ * @brief Converts to a single luminance channel (ITU-R BT.601 weights, alpha ignored).
+ */
+sgm_image sgm_to_gray(const sgm_image &image);
+
+/**
+ * @brief Box-filter resample to the requested size, each channel independently.
+ * @param ignore_zero  Treat zero samples as invalid (disparity ground truth); a target sample whose
+ *                     footprint holds no valid sample stays zero.
+ */
+sgm_image sgm_resize_area(const sgm_image &image, int width, int height, bool ignore_zero);
+
+/**
+ * @brief Packs an 8-bit-range image as interleaved R, G, B bytes (sgm_compute_rgb input). Samples are
+ * rounded and clamped to 0..255; a single-channel image is replicated, alpha is dropped.
+ */
+void sgm_to_rgb8(const sgm_image &image, std::vector<unsigned char> &rgb);
+
+/**
+ * @brief Maps a format name ("txt", "raw8", "raw16", "pfm", "png16") to its enum value.
+ */
+bool sgm_parse_disparity_format(const std::string &name, sgm_disparity_format &format);
+
+/**
+ * @brief Encodes a dense disparity map in memory and writes it with a single buffered write.
+ * @param scale  Multiplier applied before integer encoding (e.g. 256 for KITTI-style PNG16);
+ *               ignored by the text and PFM formats, which store disparities as computed.
+ */
+bool sgm_write_disparity(const std::string &path, const int *disparity, int width, int height,
+                         sgm_disparity_format format, int scale, std::string &error);
+
+#endif
@@ -0,0 +1,219 @@
+#include "quality_governor.h"
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @file quality_governor.cpp
+ * @brief Quality ladder construction, timed engine runs and the stage-cost model.
+ */
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Model units of a level: subsampled grid pixels times disparity candidates.
+ */
+static double level_units(const sgm_config_t &config)
+{
+    return (double)(config.rows / config.subsample) * (config.cols / config.subsample) * config.disp_range;
+}
+
+/**
+ * @brief Full-resolution pixels downsampled and upsampled by a level (none at subsample 1).
+ */
+static double resample_pixels(const sgm_config_t &config)
+{
+    return (config.subsample > 1) ? (double)config.rows * config.cols : 0.0;
+}
+
+/**
+ * @brief Running average of @p sample, or @p sample itself for the first one.
+ */
+static void smooth(double &average, double sample, bool first)
+{
+    average = first ? sample : average + SGM_QUALITY_SMOOTHING * (sample - average);
+}
+
+void sgm_compute_timed(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace,
+    sgm_stage_timing &timing)
+{
+    int64_t t0 = now_ns();
+    sgm_stage_cost(config, left_pixels, right_pixels, workspace);
+    int64_t t1 = now_ns();
+    sgm_stage_aggregate(config, workspace);
+    int64_t t2 = now_ns();
+    sgm_stage_wta(config, disparity_output, workspace);
+    int64_t t3 = now_ns();
+    timing.cost_ns = t1 - t0;
+    timing.aggregate_ns = t2 - t1;
+    timing.wta_ns = t3 - t2;
+}
+
+void sgm_build_quality_ladder(const sgm_config_t &base, std::vector<sgm_config_t> &ladder)
+{
+    enum
+    {
+        PATHS_8_TO_4,
+        PATHS_4_TO_2,
+        STRIDE,
+        PATHS_2_TO_1,
+        DISPARITY,
+        STRIDE_AGAIN,
+        NUM_STEPS
+    };
+
+    ladder.clear();
+    ladder.push_back(base);
+    sgm_config_t current = base;
+    for (int step = 0; step < NUM_STEPS && (int)ladder.size() < SGM_QUALITY_MAX_LEVELS; step++)
+    {
+        sgm_config_t next = current;
+        switch (step)
+        {
+        case PATHS_8_TO_4:
+            if (next.num_paths != SGM_TWO_PASS_PATHS)
+                continue;
+            next.num_paths = 4;
+            next.compress_step = 0; // 8-path storage modes
+            next.memory_bounded = 0;
+            break;
+        case PATHS_4_TO_2:
+        case PATHS_2_TO_1:
+            if (next.num_paths != ((step == PATHS_4_TO_2) ? 4 : 2))
+                continue;
+            next.num_paths /= 2;
+            break;
+        case STRIDE:
+        case STRIDE_AGAIN:
+            next.subsample *= 2;
+            break;
+        case DISPARITY:
+            if (next.disp_range < 2)
+                continue;
+            next.disp_range = (next.disp_range + 1) / 2;
+            break;
+        }
+        if (sgm_check_config(next) != 0)
+            continue;
+        ladder.push_back(next);
+        current = next;
+    }
+}
+
+sgm_quality_governor::sgm_quality_governor()
+    : cost_ns_per_unit(0.0), aggregate_ns_per_unit(0.0), wta_ns_per_unit(0.0), resample_ns_per_pixel(0.0),
+      calibrated(false)
+{
+}
+
+bool sgm_quality_governor::configure(const sgm_config_t &base, std::string &error)
+{
+    if (sgm_check_config(base) != 0 || base.cost != SGM_COST_AD)
+    {
+        error = "quality governor: base configuration rejected (the ladder needs a valid AD-cost configuration)";
+        return false;
+    }
+    sgm_build_quality_ladder(base, ladder);
+    history.assign(ladder.size(), level_history());
+    return true;
+}
+
+double sgm_quality_governor::model_ns(int index) const
+{
+    const sgm_config_t &config = ladder[index];
+    return level_units(config) * (cost_ns_per_unit + wta_ns_per_unit + aggregate_ns_per_unit * config.num_paths) +
+           resample_pixels(config) * resample_ns_per_pixel;
+}
+
+double sgm_quality_governor::correction(int index) const
+{
+    const level_history &runs = history[index];
+    if (runs.count == 0)
+        return 1.0;
+    std::vector<double> sorted(runs.ratio, runs.ratio + runs.count);
+    std::nth_element(sorted.begin(), sorted.begin() + runs.count / 2, sorted.end());
+    return sorted[runs.count / 2];
+}
+
+int64_t sgm_quality_governor::predict_ns(int index) const
+{
+    if (!calibrated)
+        return 0;
+    return (int64_t)(model_ns(index) * correction(index));
+}
+
+int sgm_quality_governor::choose(int64_t budget_ns) const
+{
+    if (!calibrated || ladder.empty())
+        return 0;
+    for (int index = 0; index < (int)ladder.size(); index++)
+    {
+        if (predict_ns(index) <= budget_ns * SGM_QUALITY_HEADROOM)
+            return index;
+    }
+    return (int)ladder.size() - 1;
+}
+
+void sgm_quality_governor::record(int index, const sgm_stage_timing &timing)
+{
+    const sgm_config_t &config = ladder[index];
+    double units = level_units(config);
+    double measured = (double)(timing.cost_ns + timing.aggregate_ns + timing.wta_ns);
+    if (resample_pixels(config) == 0.0 || !calibrated)
+    {
+        // Grid costs from full-resolution levels (or the first frame when the base itself is subsampled)
+        bool first = !calibrated;
+        smooth(cost_ns_per_unit, timing.cost_ns / units, first);
+        smooth(aggregate_ns_per_unit, timing.aggregate_ns / (units * config.num_paths), first);
+        smooth(wta_ns_per_unit, timing.wta_ns / units, first);
+        calibrated = true;
+    }
+    else
+    {
+        // Resampling: what a subsampled level takes beyond its grid work
+        double grid_ns = units * (cost_ns_per_unit + wta_ns_per_unit + aggregate_ns_per_unit * config.num_paths);
+        double extra_ns = (measured > grid_ns) ? measured - grid_ns : 0.0;
+        smooth(resample_ns_per_pixel, extra_ns / resample_pixels(config), resample_ns_per_pixel == 0.0);
+    }
+
+    double modelled = model_ns(index);
+    level_history &runs = history[index];
+    if (modelled > 0.0)
+    {
+        runs.ratio[runs.next] = measured / modelled;
+        runs.next = (runs.next + 1) % SGM_QUALITY_WINDOW;
+        runs.count = (runs.count < SGM_QUALITY_WINDOW) ? runs.count + 1 : SGM_QUALITY_WINDOW;
+    }
+}
+
+bool sgm_quality_governor::reserve(sgm_workspace_t &workspace, std::string &error) const
+{
+    for (size_t level = 0; level < ladder.size(); level++)
+    {
+        if (sgm_reserve_workspace(workspace, ladder[level]) != 0)
+        {
+            error = "cannot allocate the workspace of quality level " + std::to_string(level);
+            return false;
+        }
+    }
+    return true;
+}
+
+int sgm_quality_governor::compute(int64_t budget_ns, const float *left, const float *right, int *disparity,
+                                  sgm_workspace_t &workspace)
+{
+    int index = choose(budget_ns);
+    sgm_stage_timing timing;
+    sgm_compute_timed(ladder[index], left, right, disparity, workspace, timing);
+    record(index, timing);
+    return index;
+}
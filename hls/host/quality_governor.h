@@ -0,0 +1,123 @@
+#ifndef SGM_QUALITY_GOVERNOR_H
+#define SGM_QUALITY_GOVERNOR_H
+
+#include "sgm_hls.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * @file quality_governor.h
+ * @brief Deadline-aware graceful degradation: picks the best engine configuration that fits a time budget.
+ *
+ * A quality ladder is derived from the base configuration. Each level is one step cheaper than the one
+ * before, applied cumulatively:
+ *   8 -> 4 paths, 4 -> 2 paths, 2x coarser stride (subsample), 2 -> 1 path, half the disparity range,
+ *   2x coarser stride again.
+ * Steps that do not apply or that sgm_check_config rejects are skipped. Level 0 is the base configuration.
+ * The output keeps the base geometry at every level, because subsampled levels upsample their map.
+ *
+ * The governor times the three stages of every frame it runs (sgm_compute_timed) and keeps running costs:
+ * - cost and WTA per grid pixel and disparity, aggregation per grid pixel, disparity and path (learned from
+ *   full-resolution levels)
+ * - downsampling and upsampling per full-resolution pixel, which every subsampled level pays whatever its
+ *   grid (learned from the time subsampled levels take beyond their grid work)
+ * These per-unit costs carry over to a new geometry and estimate a level that has not run yet. Smaller grids
+ * run at a different cost per unit (cache fit, fixed overheads), so each level that has run also keeps its
+ * own correction: the median ratio of measured to modelled time over its last SGM_QUALITY_WINDOW runs (a
+ * median, so one preempted frame does not skew the level). choose() returns the best level
+ * whose predicted time fits the budget.
+ */
+
+#define SGM_QUALITY_MAX_LEVELS 8
+#define SGM_QUALITY_SMOOTHING 0.25 // Weight of the newest frame in the running stage costs
+#define SGM_QUALITY_HEADROOM 0.9   // Fraction of the budget a prediction may use
+#define SGM_QUALITY_WINDOW 5       // Recent runs per level behind its correction
+
+/**
+ * @brief Wall time of the stages of one sgm_compute() run.
+ */
+struct sgm_stage_timing
+{
+    int64_t cost_ns;
+    int64_t aggregate_ns;
+    int64_t wta_ns;
+};
+
+/**
+ * @brief sgm_compute() with its three stages timed.
+ */
+void sgm_compute_timed(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace,
+    sgm_stage_timing &timing);
+
+/**
+ * @brief Quality ladder of @p base (level 0 first); at most SGM_QUALITY_MAX_LEVELS entries.
+ */
+void sgm_build_quality_ladder(const sgm_config_t &base, std::vector<sgm_config_t> &ladder);
+
+/**
+ * @brief Stage-cost model and level choice for one stream of frames. Not thread-safe: use one per worker
+ * or per stream.
+ */
+class sgm_quality_governor
+{
+public:
+    sgm_quality_governor();
+
+    /**
+     * @brief Builds the ladder for @p base (AD cost only). The measured stage costs are kept, so a new
+     * geometry is predicted from the frames already run.
+     */
+    bool configure(const sgm_config_t &base, std::string &error);
+
+    /** @brief Reserves @p workspace for every level (sgm_reserve_workspace), before compute() at any level. */
+    bool reserve(sgm_workspace_t &workspace, std::string &error) const;
+
+    int levels() const { return (int)ladder.size(); }
+    const sgm_config_t &level(int index) const { return ladder[index]; }
+
+    /** @brief Predicted wall time of @p index (stage model times the level's correction); 0 before the first
+     * recorded frame. */
+    int64_t predict_ns(int index) const;
+
+    /**
+     * @brief Best level predicted to finish within SGM_QUALITY_HEADROOM of @p budget_ns, or the cheapest
+     * level if none does. Level 0 until a frame has been recorded.
+     */
+    int choose(int64_t budget_ns) const;
+
+    /** @brief Updates the stage costs from a frame run at @p index. */
+    void record(int index, const sgm_stage_timing &timing);
+
+    /**
+     * @brief choose(), sgm_compute_timed() at that level and record().
+     * @return The level used.
+     */
+    int compute(int64_t budget_ns, const float *left, const float *right, int *disparity, sgm_workspace_t &workspace);
+
+private:
+    struct level_history
+    {
+        double ratio[SGM_QUALITY_WINDOW]; // Measured / modelled time of the last runs (ring)
+        int count;
+        int next;
+    };
+
+    double model_ns(int index) const;
+    double correction(int index) const;
+
+    std::vector<sgm_config_t> ladder;
+    std::vector<level_history> history;
+    double cost_ns_per_unit;      // Per grid pixel and disparity
+    double aggregate_ns_per_unit; // Per grid pixel, disparity and path
+    double wta_ns_per_unit;       // Per grid pixel and disparity
+    double resample_ns_per_pixel; // Per full-resolution pixel of a subsampled level
+    bool calibrated;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "row_pipeline.h"
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @file row_pipeline.cpp
+ * @brief Cost / aggregation row handoff with acquire-release ready flags.
+ */
+
+#define SGM_ROW_SPIN_ITERATIONS 256 // Busy polls on a row flag before yielding the core
+
+void sgm_compute_row_pipelined(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    if (config.subsample > 1 || config.num_paths == SGM_TWO_PASS_PATHS || config.recompute_cost ||
+        config.single_sweep || config.mgm || config.cost != SGM_COST_AD)
+    {
+        sgm_compute(config, left_pixels, right_pixels, disparity_output, workspace);
+        return;
+    }
+
+    std::atomic<bool> row_ready[HEIGHT];
+    for (int y = 0; y < config.rows; y++)
+        row_ready[y].store(false, std::memory_order_relaxed);
+
+    // Producer: cost rows in order, each published once fully written
+    std::thread cost_thread([&]() {
+        for (int y = 0; y < config.rows; y++)
+        {
+            sgm_cost_row(config, left_pixels, right_pixels, y, workspace);
+            row_ready[y].store(true, std::memory_order_release);
+        }
+    });
+
+    // Consumer: every direction that only looks up or sideways, as soon as its cost row exists
+    bool fused_wta = config.num_paths <= 2;
+    for (int y = 0; y < config.rows; y++)
+    {
+        for (int spin = 0; !row_ready[y].load(std::memory_order_acquire); spin++)
+        {
+            if (spin >= SGM_ROW_SPIN_ITERATIONS)
+                std::this_thread::yield();
+        }
+
+        for (int path = 0; path < config.num_paths; path++)
+        {
+            if (path != SGM_PATH_BOTTOM_TO_TOP)
+                sgm_aggregate_row(config, path, y, workspace);
+        }
+        if (fused_wta)
+            sgm_wta_row(config, y, disparity_output, workspace);
+    }
+    cost_thread.join();
+
+    // Bottom-to-top depends on the last row; each finished row can be selected right away
+    if (!fused_wta)
+    {
+        for (int y = config.rows - 1; y >= 0; y--)
+        {
+            sgm_aggregate_row(config, SGM_PATH_BOTTOM_TO_TOP, y, workspace);
+            sgm_wta_row(config, y, disparity_output, workspace);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SGM_ROW_PIPELINE_H
+#define SGM_ROW_PIPELINE_H
+
+#include "sgm_hls.h"
+
+/**
+ * @file row_pipeline.h
+ * @brief Row-granular two-thread SGM: matching cost runs ahead on a helper thread while the calling thread
+ * aggregates the rows that are already available.
+ *
+ * The cost thread publishes each finished row through a per-row ready flag. The calling thread waits on
+ * the flag of row y, then aggregates every direction that only depends on rows above and on the same row
+ * (left-to-right, top-to-bottom, right-to-left). For 1- and 2-path configurations it selects the disparity
+ * of row y immediately, so the frame finishes one row after its last cost row. Bottom-to-top needs the
+ * whole frame, so the 4-path configuration runs it afterwards, fused with WTA, from the last row upwards.
+ * The result is bit-identical to sgm_compute().
+ */
+
+/**
+ * @brief Same contract as sgm_compute(); subsampled, 8-path, recompute, single-sweep, MGM and MI-cost
+ * configurations fall back to it.
+ */
+void sgm_compute_row_pipelined(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+#endif
@@ -0,0 +1,309 @@
+#include "run_config.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+
+/**
+ * @file run_config.cpp
+ * @brief Parsing and validation of sgm_run_config settings.
+ */
+
+/**
+ * @brief Integer setting with a mandatory full-string parse.
+ */
+static bool parse_int(const std::string &key, const std::string &value, int &target, std::string &error)
+{
+    char *end = 0;
+    errno = 0;
+    long parsed = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno != 0 || parsed < INT_MIN || parsed > INT_MAX)
+    {
+        error = key + ": expected an integer, got \"" + value + "\"";
+        return false;
+    }
+    target = (int)parsed;
+    return true;
+}
+
+/**
+ * @brief Boolean setting: 0/1, true/false, yes/no, on/off.
+ */
+static bool parse_flag(const std::string &key, const std::string &value, int &target, std::string &error)
+{
+    if (value == "1" || value == "true" || value == "yes" || value == "on")
+        target = 1;
+    else if (value == "0" || value == "false" || value == "no" || value == "off")
+        target = 0;
+    else
+    {
+        error = key + ": expected 0 or 1, got \"" + value + "\"";
+        return false;
+    }
+    return true;
+}
+
+static std::string trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+        return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+void sgm_default_run_config(sgm_run_config &run)
+{
+    run.input = SGM_INPUT_PAIR;
+    run.left.clear();
+    run.right.clear();
+    run.dataset.clear();
+    run.list.clear();
+    run.shm_input = "/sgm_frames";
+    run.shm_output = "/sgm_disparity";
+    run.shm_slots = 4;
+    run.shm_timeout_ms = 5000;
+    run.engine = sgm_default_config();
+    run.hmi = false;
+    run.threads = 1;
+    run.backend = SGM_BACKEND_FRAME;
+    run.repeat = 1;
+    run.budget_ms = 0;
+    run.output_dir.clear();
+    run.output_format = SGM_FORMAT_PNG16;
+    run.output_scale = 1;
+    run.verbose = false;
+}
+
+bool sgm_set_run_option(sgm_run_config &run, const std::string &key, const std::string &value, std::string &error)
+{
+    sgm_config_t &engine = run.engine;
+    int flag;
+
+    // Inputs
+    if (key == "input")
+    {
+        if (value == "pair")
+            run.input = SGM_INPUT_PAIR;
+        else if (value == "dataset")
+            run.input = SGM_INPUT_DATASET;
+        else if (value == "list")
+            run.input = SGM_INPUT_LIST;
+        else if (value == "shm")
+            run.input = SGM_INPUT_SHM;
+        else
+        {
+            error = "input: expected pair, dataset, list or shm, got \"" + value + "\"";
+            return false;
+        }
+        return true;
+    }
+    if (key == "left")
+    {
+        run.left = value;
+        return true;
+    }
+    if (key == "right")
+    {
+        run.right = value;
+        return true;
+    }
+    if (key == "dataset")
+    {
+        run.dataset = value;
+        return true;
+    }
+    if (key == "list")
+    {
+        run.list = value;
+        return true;
+    }
+    if (key == "shm_input")
+    {
+        run.shm_input = value;
+        return true;
+    }
+    if (key == "shm_output")
+    {
+        run.shm_output = value;
+        return true;
+    }
+    if (key == "shm_slots")
+        return parse_int(key, value, run.shm_slots, error);
+    if (key == "shm_timeout_ms")
+        return parse_int(key, value, run.shm_timeout_ms, error);
+
+    // Engine
+    if (key == "rows")
+        return parse_int(key, value, engine.rows, error);
+    if (key == "cols")
+        return parse_int(key, value, engine.cols, error);
+    if (key == "disp_range")
+        return parse_int(key, value, engine.disp_range, error);
+    if (key == "paths")
+        return parse_int(key, value, engine.num_paths, error);
+    if (key == "subsample")
+        return parse_int(key, value, engine.subsample, error);
+    if (key == "p1")
+        return parse_int(key, value, engine.p1, error);
+    if (key == "p2")
+        return parse_int(key, value, engine.p2, error);
+    if (key == "compress_step")
+        return parse_int(key, value, engine.compress_step, error);
+    if (key == "recompute_cost")
+        return parse_flag(key, value, engine.recompute_cost, error);
+    if (key == "single_sweep")
+        return parse_flag(key, value, engine.single_sweep, error);
+    if (key == "memory_bounded")
+        return parse_flag(key, value, engine.memory_bounded, error);
+    if (key == "mgm")
+        return parse_flag(key, value, engine.mgm, error);
+    if (key == "cost")
+    {
+        if (value != "ad" && value != "hmi")
+        {
+            error = "cost: expected ad or hmi, got \"" + value + "\"";
+            return false;
+        }
+        run.hmi = (value == "hmi");
+        return true;
+    }
+
+    // Execution
+    if (key == "threads")
+        return parse_int(key, value, run.threads, error);
+    if (key == "repeat")
+        return parse_int(key, value, run.repeat, error);
+    if (key == "budget_ms")
+        return parse_int(key, value, run.budget_ms, error);
+    if (key == "backend")
+    {
+        if (value == "frame")
+            run.backend = SGM_BACKEND_FRAME;
+        else if (value == "row_pipeline")
+            run.backend = SGM_BACKEND_ROW_PIPELINE;
+        else
+        {
+            error = "backend: expected frame or row_pipeline, got \"" + value + "\"";
+            return false;
+        }
+        return true;
+    }
+
+    // Output
+    if (key == "output_dir")
+    {
+        run.output_dir = value;
+        return true;
+    }
+    if (key == "output_format")
+    {
+        if (!sgm_parse_disparity_format(value, run.output_format))
+        {
+            error = "output_format: expected txt, raw8, raw16, pfm or png16, got \"" + value + "\"";
+            return false;
+        }
+        return true;
+    }
+    if (key == "output_scale")
+        return parse_int(key, value, run.output_scale, error);
+    if (key == "verbose")
+    {
+        if (!parse_flag(key, value, flag, error))
+            return false;
+        run.verbose = (flag != 0);
+        return true;
+    }
+
+    error = "unknown setting \"" + key + "\"";
+    return false;
+}
+
+bool sgm_read_run_config(const std::string &path, sgm_run_config &run, std::string &error)
+{
+    std::ifstream stream(path.c_str());
+    if (!stream.is_open())
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(stream, line); number++)
+    {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos)
+        {
+            error = path + ":" + std::to_string(number) + ": expected key = value";
+            return false;
+        }
+        if (!sgm_set_run_option(run, trim(line.substr(0, equals)), trim(line.substr(equals + 1)), error))
+        {
+            error = path + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sgm_check_run_config(const sgm_run_config &run, std::string &error)
+{
+    if (run.input == SGM_INPUT_PAIR && (run.left.empty() || run.right.empty()))
+        error = "input = pair needs left and right";
+    else if (run.input == SGM_INPUT_DATASET && run.dataset.empty())
+        error = "input = dataset needs dataset";
+    else if (run.input == SGM_INPUT_LIST && run.list.empty())
+        error = "input = list needs list";
+    else if (run.input == SGM_INPUT_SHM && (run.shm_input.empty() || run.shm_output.empty() || run.shm_slots < 1 ||
+                                            run.shm_timeout_ms < 0))
+        error = "input = shm needs shm_input, shm_output, shm_slots >= 1 and shm_timeout_ms >= 0";
+    else if (run.input == SGM_INPUT_SHM && (run.backend != SGM_BACKEND_FRAME || run.budget_ms > 0 || run.repeat != 1))
+        error = "input = shm runs the frame backend once per frame, without budget_ms";
+    else if (sgm_check_config(run.engine) != 0)
+        error = "engine configuration rejected (geometry beyond " + std::to_string(WIDTH) + "x" +
+                std::to_string(HEIGHT) + "x" + std::to_string(MAX_DISP) + " or unsupported mode combination)";
+    else if (run.threads < 1 || run.repeat < 1 || run.output_scale < 1)
+        error = "threads, repeat and output_scale must be at least 1";
+    else if (run.budget_ms < 0 || (run.budget_ms > 0 && (run.hmi || run.backend != SGM_BACKEND_FRAME)))
+        error = "budget_ms must not be negative and needs cost = ad and backend = frame";
+    else
+        return true;
+    return false;
+}
+
+void sgm_print_run_options(std::ostream &stream)
+{
+    stream << "Settings (config file: key = value, command line: --key=value):\n"
+              "  input          pair | dataset | list | shm\n"
+              "  left, right    pair input: PNG, PFM or pixel text (.txt, cols x rows samples)\n"
+              "  dataset        dataset root (Middlebury / KITTI layouts, see dataset.h)\n"
+              "  list           file of \"left right [name]\" lines, - for stdin\n"
+              "  shm_input, shm_output\n"
+              "                 shm input: names of the frame and disparity rings the driver creates\n"
+              "                 (default /sgm_frames, /sgm_disparity); maps go to the output ring\n"
+              "  shm_slots      shm input: slots per ring (default 4)\n"
+              "  shm_timeout_ms shm input: wait for the capture process, 0 = forever (default 5000)\n"
+              "  rows, cols     processing grid (images are area-resampled to fit)\n"
+              "  disp_range     disparity candidates\n"
+              "  paths          1, 2, 4 or 8\n"
+              "  subsample, p1, p2, compress_step, recompute_cost, single_sweep, memory_bounded, mgm\n"
+              "                 engine options (see sgm_config_t)\n"
+              "  cost           ad | hmi\n"
+              "  threads        frames processed concurrently\n"
+              "  backend        frame | row_pipeline\n"
+              "  repeat         engine runs per frame (benchmarking)\n"
+              "  budget_ms      per-run time budget: fewer paths, coarser stride, fewer disparities\n"
+              "                 as needed (0 = off, frame backend and ad cost only)\n"
+              "  output_dir     directory for disparity maps (omit to discard)\n"
+              "  output_format  txt | raw8 | raw16 | pfm | png16\n"
+              "  output_scale   disparity multiplier for the integer formats\n"
+              "  verbose        0 | 1: one line per frame\n";
+}
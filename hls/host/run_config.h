@@ -0,0 +1,86 @@
+#ifndef SGM_RUN_CONFIG_H
+#define SGM_RUN_CONFIG_H
+
+#include "sgm_hls.h"
+#include "image_io.h"
+#include <iosfwd>
+#include <string>
+
+/**
+ * @file run_config.h
+ * @brief Run configuration of the host tools: inputs, engine parameters, threading, backend and output.
+ *
+ * Settings are "key = value" lines in a config file ('#' starts a comment) and may be overridden on the
+ * command line as --key=value; both go through sgm_set_run_option, so every key is valid in both places.
+ * Recognized keys are listed by sgm_print_run_options.
+ */
+
+enum sgm_input_mode
+{
+    SGM_INPUT_PAIR = 0, // One left / right file pair
+    SGM_INPUT_DATASET,  // Every pair below a Middlebury / KITTI directory tree (see dataset.h)
+    SGM_INPUT_LIST,     // "left right [name]" lines from a file, or from stdin for "-" (streamed)
+    SGM_INPUT_SHM       // Frames of a capture process on shared-memory rings, served in place (shm_ring.h)
+};
+
+enum sgm_backend
+{
+    SGM_BACKEND_FRAME = 0,    // sgm_compute() / sgm_compute_hmi() per frame
+    SGM_BACKEND_ROW_PIPELINE  // sgm_compute_row_pipelined(): cost thread runs ahead of aggregation
+};
+
+/**
+ * @brief Complete description of a production run.
+ */
+struct sgm_run_config
+{
+    sgm_input_mode input;
+    std::string left;    // Pair input: PNG, PFM, or pixel text (.txt, engine.cols x engine.rows)
+    std::string right;
+    std::string dataset; // Dataset root
+    std::string list;    // Pair list path, "-" for stdin
+    std::string shm_input;  // Shm input: ring of stereo frames created by the driver, e.g. "/sgm_frames"
+    std::string shm_output; // Shm input: ring the disparity maps are written to
+    int shm_slots;          // Slots per ring
+    int shm_timeout_ms;     // Wait for the capture process before it is presumed dead; 0 waits forever
+
+    sgm_config_t engine; // rows / cols: largest processing grid; images are area-resampled to fit
+    bool hmi;            // cost = hmi: hierarchical mutual information (sgm_compute_hmi)
+
+    int threads;         // Frames processed concurrently, one workspace each
+    sgm_backend backend;
+    int repeat;          // Engine runs per frame (benchmarking); the last result is written
+    int budget_ms;       // > 0: per-run time budget met by stepping down the quality ladder (frame backend, AD)
+
+    std::string output_dir; // Empty: disparity maps are not written
+    sgm_disparity_format output_format;
+    int output_scale;
+    bool verbose;           // One line per frame
+};
+
+/**
+ * @brief Defaults: pair input, sgm_default_config(), AD cost, one thread, frame backend, no output.
+ */
+void sgm_default_run_config(sgm_run_config &run);
+
+/**
+ * @brief Applies one "key = value" setting.
+ */
+bool sgm_set_run_option(sgm_run_config &run, const std::string &key, const std::string &value, std::string &error);
+
+/**
+ * @brief Applies every setting of a config file.
+ */
+bool sgm_read_run_config(const std::string &path, sgm_run_config &run, std::string &error);
+
+/**
+ * @brief Checks inputs, engine configuration (sgm_check_config) and run parameters for consistency.
+ */
+bool sgm_check_run_config(const sgm_run_config &run, std::string &error);
+
+/**
+ * @brief Writes the list of keys with their meaning (usage text).
+ */
+void sgm_print_run_options(std::ostream &stream);
+
+#endif
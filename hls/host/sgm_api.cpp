@@ -0,0 +1,174 @@
+#include "sgm_api.h"
+#include "sgm_hls.h"
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+/**
+ * @file sgm_api.cpp
+ * @brief C interface implementation: handle management and translation to the C++ engine calls.
+ *
+ * Frames are wrapped in sgm_image_view_t and read in place by the cost stage. No exception crosses the C
+ * boundary; allocation failures are reported as SGM_API_ERROR_MEMORY.
+ */
+
+#define SGM_API_CONFIG_V1_BYTES (offsetof(sgm_api_config, cost) + sizeof(int32_t)) // Members of API 1.0
+
+static_assert(SGM_API_PIXEL_U8 == SGM_PIXEL_U8 && SGM_API_PIXEL_U16 == SGM_PIXEL_U16 &&
+                  SGM_API_PIXEL_F32 == SGM_PIXEL_F32,
+              "C API pixel types must match sgm_image_view_t");
+
+struct sgm_engine
+{
+    sgm_config_t config;
+    sgm_workspace_t *workspace;
+};
+
+extern "C" {
+
+uint32_t sgm_api_version(void)
+{
+    return SGM_API_VERSION;
+}
+
+void sgm_api_limits(int32_t *rows, int32_t *cols, int32_t *disp_range)
+{
+    if (rows)
+        *rows = HEIGHT;
+    if (cols)
+        *cols = WIDTH;
+    if (disp_range)
+        *disp_range = MAX_DISP;
+}
+
+void sgm_api_default_config(sgm_api_config *config)
+{
+    if (!config)
+        return;
+    sgm_config_t defaults = sgm_default_config();
+    std::memset(config, 0, sizeof(*config));
+    config->struct_size = sizeof(sgm_api_config);
+    config->rows = defaults.rows;
+    config->cols = defaults.cols;
+    config->disp_range = defaults.disp_range;
+    config->num_paths = defaults.num_paths;
+    config->subsample = defaults.subsample;
+    config->p1 = defaults.p1;
+    config->p2 = defaults.p2;
+    config->compress_step = defaults.compress_step;
+    config->recompute_cost = defaults.recompute_cost;
+    config->single_sweep = defaults.single_sweep;
+    config->memory_bounded = defaults.memory_bounded;
+    config->mgm = defaults.mgm;
+    config->cost = defaults.cost;
+}
+
+const char *sgm_api_status_string(int status)
+{
+    switch (status)
+    {
+    case SGM_API_OK:
+        return "ok";
+    case SGM_API_ERROR_ARGUMENT:
+        return "invalid argument";
+    case SGM_API_ERROR_CONFIG:
+        return "configuration not supported by this build";
+    case SGM_API_ERROR_MEMORY:
+        return "out of memory";
+    default:
+        return "unknown status";
+    }
+}
+
+sgm_engine *sgm_create(const sgm_api_config *config, int *status)
+{
+    int result = SGM_API_OK;
+    sgm_engine *engine = 0;
+
+    if (!config || config->struct_size < SGM_API_CONFIG_V1_BYTES)
+        result = SGM_API_ERROR_ARGUMENT;
+    else
+    {
+        sgm_config_t core;
+        core.rows = config->rows;
+        core.cols = config->cols;
+        core.disp_range = config->disp_range;
+        core.num_paths = config->num_paths;
+        core.subsample = config->subsample;
+        core.p1 = config->p1;
+        core.p2 = config->p2;
+        core.compress_step = config->compress_step;
+        core.recompute_cost = config->recompute_cost;
+        core.single_sweep = config->single_sweep;
+        core.memory_bounded = config->memory_bounded;
+        core.mgm = config->mgm;
+        core.cost = config->cost;
+
+        if (sgm_check_config(core) != 0)
+            result = SGM_API_ERROR_CONFIG;
+        else
+        {
+            engine = new (std::nothrow) sgm_engine;
+            if (engine)
+            {
+                engine->config = core;
+                engine->workspace = sgm_create_workspace(core); // Only the buffers of this mode
+            }
+            if (!engine || !engine->workspace)
+            {
+                delete engine;
+                engine = 0;
+                result = SGM_API_ERROR_MEMORY;
+            }
+        }
+    }
+
+    if (status)
+        *status = result;
+    return engine;
+}
+
+int sgm_compute(sgm_engine *engine, const float *left, const float *right, size_t stride, int32_t *out)
+{
+    return sgm_compute_pixels(engine, left, right, SGM_API_PIXEL_F32, stride, out);
+}
+
+int sgm_compute_pixels(sgm_engine *engine, const void *left, const void *right, int pixel_type, size_t stride,
+                       int32_t *out)
+{
+    if (!engine || !left || !right || !out)
+        return SGM_API_ERROR_ARGUMENT;
+    if (pixel_type != SGM_API_PIXEL_U8 && pixel_type != SGM_API_PIXEL_U16 && pixel_type != SGM_API_PIXEL_F32)
+        return SGM_API_ERROR_ARGUMENT;
+
+    const sgm_config_t &config = engine->config;
+    size_t pixel_bytes = (pixel_type == SGM_API_PIXEL_U8) ? 1 : (pixel_type == SGM_API_PIXEL_U16) ? 2 : 4;
+    if (stride == 0)
+        stride = (size_t)config.cols * pixel_bytes;
+    if (stride > 0x7fffffff)
+        return SGM_API_ERROR_ARGUMENT;
+
+    sgm_image_view_t left_view = sgm_make_view(left, pixel_type, (int)stride);
+    sgm_image_view_t right_view = sgm_make_view(right, pixel_type, (int)stride);
+    if (sgm_check_view_config(config, left_view, right_view) != 0)
+        return (config.cost == SGM_COST_MI && pixel_type == SGM_API_PIXEL_U16) ? SGM_API_ERROR_CONFIG
+                                                                               : SGM_API_ERROR_ARGUMENT;
+
+    int status;
+    if (config.cost == SGM_COST_MI)
+        status = sgm_compute_hmi_view(config, left_view, right_view, out, *engine->workspace);
+    else
+        status = sgm_compute_view(config, left_view, right_view, out, *engine->workspace);
+    return (status == 0) ? SGM_API_OK : SGM_API_ERROR_ARGUMENT;
+}
+
+void sgm_destroy(sgm_engine *engine)
+{
+    if (!engine)
+        return;
+    sgm_destroy_workspace(engine->workspace);
+    delete engine;
+}
+
+} // extern "C"
@@ -0,0 +1,124 @@
+#ifndef SGM_API_H
+#define SGM_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file sgm_api.h
+ * @brief Stable C interface of the SGM engine, built as the shared library libsgm.so.
+ *
+ * Plain C types only, so C, Rust (bindgen / extern "C") and other FFI callers can embed the engine
+ * without the HLS headers. An engine handle owns its configuration and workspace; calls on one handle
+ * must not overlap, separate handles run concurrently. Input rows may be padded (stride in bytes) and
+ * pixels may be 8-bit, 16-bit or float; the cost kernel reads the caller's buffers in place.
+ *
+ * Compatibility: the major version changes only when an existing signature or struct member changes;
+ * minor versions add functions or append members to sgm_api_config, whose struct_size tells the library
+ * which members the caller knows about.
+ */
+
+#define SGM_API_VERSION_MAJOR 1
+#define SGM_API_VERSION_MINOR 1
+#define SGM_API_VERSION ((SGM_API_VERSION_MAJOR << 16) | SGM_API_VERSION_MINOR)
+
+#if defined(_WIN32)
+#define SGM_API_EXPORT __declspec(dllexport)
+#else
+#define SGM_API_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --- Status codes --- */
+#define SGM_API_OK 0
+#define SGM_API_ERROR_ARGUMENT -1 // Null pointer, or a stride shorter than one row / not a multiple of 4
+#define SGM_API_ERROR_CONFIG -2   // Configuration rejected (geometry beyond the compiled maxima, invalid mode)
+#define SGM_API_ERROR_MEMORY -3   // Workspace allocation failed
+
+/* --- Pixel types (API 1.1) --- */
+#define SGM_API_PIXEL_U8 0  // uint8_t
+#define SGM_API_PIXEL_U16 1 // uint16_t; costs are in its intensity units, so scale p1 / p2 for > 8-bit data
+#define SGM_API_PIXEL_F32 2 // float
+
+/**
+ * @brief Engine configuration; mirrors sgm_config_t. Initialize with sgm_api_default_config().
+ */
+typedef struct
+{
+    uint32_t struct_size; // sizeof(sgm_api_config) of the caller's header version
+    int32_t rows;         // Frame height (compiled maxima: sgm_api_limits)
+    int32_t cols;         // Frame width
+    int32_t disp_range;   // Disparity candidates
+    int32_t num_paths;    // 1, 2, 4 or 8 aggregation directions
+    int32_t subsample;    // Processing stride (1 = full resolution)
+    int32_t p1;           // Small disparity change penalty
+    int32_t p2;           // Large disparity change penalty
+    int32_t compress_step;
+    int32_t recompute_cost;
+    int32_t single_sweep;
+    int32_t memory_bounded;
+    int32_t mgm;
+    int32_t cost;         // 0 absolute difference, 1 mutual information (hierarchical, see sgm_compute_hmi)
+} sgm_api_config;
+
+typedef struct sgm_engine sgm_engine; /* Opaque */
+
+/**
+ * @return SGM_API_VERSION of the loaded library (check the major version against the header's).
+ */
+SGM_API_EXPORT uint32_t sgm_api_version(void);
+
+/**
+ * @brief Compiled maxima (HEIGHT, WIDTH, MAX_DISP) of the loaded library. Any pointer may be null.
+ */
+SGM_API_EXPORT void sgm_api_limits(int32_t *rows, int32_t *cols, int32_t *disp_range);
+
+/**
+ * @brief Fills @p config with the engine defaults (full compiled frame, 4 paths, default penalties).
+ */
+SGM_API_EXPORT void sgm_api_default_config(sgm_api_config *config);
+
+/**
+ * @brief Human-readable text of a status code.
+ */
+SGM_API_EXPORT const char *sgm_api_status_string(int status);
+
+/**
+ * @brief Validates @p config and allocates an engine with its own workspace.
+ * @param status  Optional; receives SGM_API_OK or the reason for a null result.
+ * @return Engine handle, or null.
+ */
+SGM_API_EXPORT sgm_engine *sgm_create(const sgm_api_config *config, int *status);
+
+/**
+ * @brief Disparity map of one rectified float32 gray pair.
+ * @param left, right  Row-major config.rows x config.cols frames, row y starting at byte y * stride.
+ * @param stride       Bytes between input rows (>= cols * sizeof(float), multiple of 4); 0 means packed rows.
+ * @param out          Packed config.rows x config.cols int32 disparities.
+ * @return SGM_API_OK or SGM_API_ERROR_ARGUMENT.
+ */
+SGM_API_EXPORT int sgm_compute(sgm_engine *engine, const float *left, const float *right, size_t stride,
+                               int32_t *out);
+
+/**
+ * @brief sgm_compute for frames of SGM_API_PIXEL_* samples (API 1.1). A region of interest of a larger
+ * image is passed as a pointer to its first pixel plus the full image stride.
+ * @param stride  Bytes between input rows (>= cols pixels, multiple of the pixel size); 0 means packed rows.
+ * @return SGM_API_OK, SGM_API_ERROR_ARGUMENT, or SGM_API_ERROR_CONFIG (16-bit input with the MI cost).
+ */
+SGM_API_EXPORT int sgm_compute_pixels(sgm_engine *engine, const void *left, const void *right, int pixel_type,
+                                      size_t stride, int32_t *out);
+
+/**
+ * @brief Releases the engine (null is ignored).
+ */
+SGM_API_EXPORT void sgm_destroy(sgm_engine *engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
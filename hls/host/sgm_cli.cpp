@@ -0,0 +1,385 @@
+#include "sgm_hls.h"
+#include "sgm_profile.h"
+#include "dataset.h"
+#include "image_io.h"
+#include "quality_governor.h"
+#include "row_pipeline.h"
+#include "run_config.h"
+#include "shm_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file sgm_cli.cpp
+ * @brief Command-line driver for production runs and benchmarks of the host engine.
+ *
+ * Reads a run configuration (run_config.h) from an optional config file and --key=value overrides,
+ * then processes a single pair, a dataset tree or a streamed pair list on `threads` workers, each with
+ * its own workspace. Every worker claims the next pair, loads it, runs the selected backend `repeat`
+ * times and writes the last disparity map. The summary reports frame rate, pixel throughput and the
+ * per-run latency distribution. With budget_ms each worker's quality governor picks the level of every
+ * run (quality_governor.h), and the summary adds the runs per level. With input = shm the driver creates
+ * the frame and disparity rings and serves a capture process in place (sgm_shm_serve) until it closes the
+ * frame ring.
+ *
+ * Usage: sgm_cli [config_file] [--key=value ...]
+ */
+
+/**
+ * @brief Hands out pairs to the workers; the list input is read lazily, so stdin can stream pairs.
+ */
+class frame_source
+{
+public:
+    frame_source() : next_index(0), list_stream(0), line_number(0) {}
+
+    bool open(const sgm_run_config &run, std::string &error)
+    {
+        if (run.input == SGM_INPUT_PAIR)
+        {
+            sgm_stereo_pair pair;
+            pair.name = stem(run.left);
+            pair.left_path = run.left;
+            pair.right_path = run.right;
+            pair.gt_scale = 0.0;
+            pairs.push_back(pair);
+            return true;
+        }
+        if (run.input == SGM_INPUT_DATASET)
+            return sgm_scan_dataset(run.dataset, pairs, error);
+
+        if (run.list == "-")
+        {
+            list_stream = &std::cin;
+            return true;
+        }
+        list_file.open(run.list.c_str());
+        if (!list_file.is_open())
+        {
+            error = "cannot open " + run.list;
+            return false;
+        }
+        list_stream = &list_file;
+        return true;
+    }
+
+    /**
+     * @return False at the end of the input; @p error is set for a malformed list line.
+     */
+    bool next(sgm_stereo_pair &pair, std::string &error)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!list_stream)
+        {
+            if (next_index >= pairs.size())
+                return false;
+            pair = pairs[next_index++];
+            return true;
+        }
+
+        std::string line;
+        while (std::getline(*list_stream, line))
+        {
+            line_number++;
+            std::istringstream fields(line);
+            std::string left, right, name;
+            if (!(fields >> left) || left[0] == '#')
+                continue;
+            if (!(fields >> right))
+            {
+                error = "list line " + std::to_string(line_number) + ": expected \"left right [name]\"";
+                pair.name.clear();
+                return true;
+            }
+            fields >> name;
+            pair.name = name.empty() ? stem(left) : name;
+            pair.left_path = left;
+            pair.right_path = right;
+            pair.gt_path.clear();
+            pair.gt_scale = 0.0;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    static std::string stem(const std::string &path)
+    {
+        size_t slash = path.find_last_of('/');
+        std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        size_t dot = name.find_last_of('.');
+        return (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+    }
+
+    std::mutex mutex;
+    std::vector<sgm_stereo_pair> pairs;
+    size_t next_index;
+    std::ifstream list_file;
+    std::istream *list_stream;
+    int line_number;
+};
+
+/**
+ * @brief Loads a pair onto the processing grid: pixel text at the configured geometry, images resampled.
+ */
+static bool load_frame(const sgm_run_config &run, const sgm_stereo_pair &pair, sgm_loaded_pair &loaded,
+                       std::string &error)
+{
+    const std::string &path = pair.left_path;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".txt") == 0)
+    {
+        loaded.rows = run.engine.rows;
+        loaded.cols = run.engine.cols;
+        loaded.ground_truth = sgm_image();
+        return sgm_read_pixel_text(pair.left_path, loaded.cols, loaded.rows, loaded.left, error) &&
+               sgm_read_pixel_text(pair.right_path, loaded.cols, loaded.rows, loaded.right, error);
+    }
+    return sgm_load_pair(pair, run.engine.cols, run.engine.rows, loaded, error);
+}
+
+/**
+ * @brief One engine run with the configured cost and backend.
+ * @return Quality level of the run (always 0 without a budget).
+ */
+static int run_engine(const sgm_run_config &run, const sgm_config_t &config, const sgm_loaded_pair &frame,
+                      int *disparity, sgm_workspace_t &workspace, sgm_quality_governor &governor)
+{
+    const float *left = &frame.left.pixels[0];
+    const float *right = &frame.right.pixels[0];
+    if (run.budget_ms > 0)
+        return governor.compute((int64_t)run.budget_ms * 1000000, left, right, disparity, workspace);
+    if (run.hmi)
+        sgm_compute_hmi(config, left, right, disparity, workspace);
+    else if (run.backend == SGM_BACKEND_ROW_PIPELINE)
+        sgm_compute_row_pipelined(config, left, right, disparity, workspace);
+    else
+        sgm_compute(config, left, right, disparity, workspace);
+    return 0;
+}
+
+/**
+ * @brief input = shm: creates both rings and serves the capture process until it closes the frame ring.
+ * @return Process exit code.
+ */
+static int serve_shm(const sgm_run_config &run)
+{
+    std::string error;
+    sgm_config_t config = run.engine;
+    config.cost = run.hmi ? SGM_COST_MI : config.cost;
+    sgm_shm_ring input, output;
+    sgm_workspace_t *workspace = sgm_create_workspace(config);
+    if (!workspace)
+        error = "cannot allocate the workspace";
+    else if (input.create(run.shm_input, run.shm_slots, SGM_SHM_INPUT_SLOT_BYTES, error) &&
+             output.create(run.shm_output, run.shm_slots, SGM_SHM_OUTPUT_SLOT_BYTES, error))
+    {
+        std::cout << ">>> Serving " << run.shm_input << " -> " << run.shm_output << " (" << run.shm_slots
+                  << " slots, frames up to " << WIDTH << "x" << HEIGHT << ")" << std::endl;
+        sgm_shm_serve_stats stats;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool ok = sgm_shm_serve(input, output, config, *workspace, stats, error,
+                                run.shm_timeout_ms > 0 ? (int64_t)run.shm_timeout_ms * 1000000 : -1);
+        double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf(">>> Served %llu frame(s), %llu failed, in %.3f s: %.2f frames/s, mean capture-to-result "
+                    "latency %.3f ms\n",
+                    (unsigned long long)stats.frames, (unsigned long long)stats.failed, wall_s, stats.frames / wall_s,
+                    stats.frames > 0 ? stats.latency_ns / 1e6 / stats.frames : 0.0);
+        sgm_destroy_workspace(workspace);
+        if (!ok)
+            std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return (ok && stats.failed == 0) ? 0 : 1;
+    }
+    sgm_destroy_workspace(workspace);
+    std::cerr << "CRITICAL ERROR: " << error << std::endl;
+    return -1;
+}
+
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char **argv)
+{
+    sgm_run_config run;
+    sgm_default_run_config(run);
+    std::string error;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-h" || argument == "--help")
+        {
+            std::cout << "Usage: " << argv[0] << " [config_file] [--key=value ...]\n";
+            sgm_print_run_options(std::cout);
+            return 0;
+        }
+        bool ok;
+        if (argument.compare(0, 2, "--") == 0)
+        {
+            size_t equals = argument.find('=');
+            if (equals == std::string::npos)
+            {
+                std::cerr << "CRITICAL ERROR: expected --key=value, got " << argument << std::endl;
+                return -1;
+            }
+            ok = sgm_set_run_option(run, argument.substr(2, equals - 2), argument.substr(equals + 1), error);
+        }
+        else
+            ok = sgm_read_run_config(argument, run, error);
+        if (!ok)
+        {
+            std::cerr << "CRITICAL ERROR: " << error << std::endl;
+            return -1;
+        }
+    }
+
+    frame_source source;
+    if (sgm_check_run_config(run, error) && run.input == SGM_INPUT_SHM)
+        return serve_shm(run);
+    if (!error.empty() || !source.open(run, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    static const char *const input_names[] = {"pair", "dataset", "list", "shm"};
+    static const char *const backend_names[] = {"frame", "row_pipeline"};
+    static const char *const output_suffix[] = {".txt", "_u8.raw", "_u16.raw", ".pfm", "_16bit.png"};
+    std::cout << ">>> SGM CLI: input " << input_names[run.input] << ", grid <= " << run.engine.cols << "x"
+              << run.engine.rows << ", " << run.engine.disp_range << " disparities, " << run.engine.num_paths
+              << " path(s), cost " << (run.hmi ? "hmi" : "ad") << ", backend " << backend_names[run.backend]
+              << ", " << run.threads << " thread(s), repeat " << run.repeat << std::endl;
+
+    std::mutex result_mutex;
+    std::vector<double> latencies_ms;
+    std::vector<long> level_runs(SGM_QUALITY_MAX_LEVELS, 0);
+    double total_pixels = 0.0, total_load_ms = 0.0;
+    int frames = 0, failures = 0;
+
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < run.threads; w++)
+    {
+        workers.push_back(std::thread([&]() {
+            sgm_config_t reserved = run.engine;
+            reserved.cost = run.hmi ? SGM_COST_MI : reserved.cost;
+            sgm_workspace_t *workspace = sgm_create_workspace(reserved);
+            if (!workspace)
+            {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                failures++;
+                std::cerr << ">>> cannot allocate the worker workspace" << std::endl;
+                return;
+            }
+            std::vector<int> disparity(HEIGHT * WIDTH);
+            std::vector<double> run_ms;
+            std::vector<int> run_levels;
+            sgm_quality_governor governor; // Stage costs carry over between frames of this worker
+            sgm_stereo_pair pair;
+            std::string frame_error;
+
+            while (source.next(pair, frame_error))
+            {
+                sgm_loaded_pair frame;
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                bool ok = frame_error.empty() && load_frame(run, pair, frame, frame_error);
+                double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+                sgm_config_t config = run.engine;
+                run_ms.clear();
+                run_levels.clear();
+                if (ok)
+                {
+                    config.rows = frame.rows;
+                    config.cols = frame.cols;
+                    if (run.budget_ms > 0 && (governor.levels() == 0 || governor.level(0).rows != config.rows ||
+                                              governor.level(0).cols != config.cols))
+                        ok = governor.configure(config, frame_error) && governor.reserve(*workspace, frame_error);
+                }
+                if (ok)
+                {
+                    for (int r = 0; r < run.repeat; r++)
+                    {
+                        t0 = std::chrono::steady_clock::now();
+                        run_levels.push_back(run_engine(run, config, frame, &disparity[0], *workspace, governor));
+                        run_ms.push_back(
+                            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+                    }
+                }
+                if (ok && !run.output_dir.empty())
+                {
+                    std::string name = pair.name;
+                    std::replace(name.begin(), name.end(), '/', '_');
+                    ok = sgm_write_disparity(run.output_dir + "/" + name + output_suffix[run.output_format],
+                                             &disparity[0], config.cols, config.rows, run.output_format,
+                                             run.output_scale, frame_error);
+                }
+
+                std::lock_guard<std::mutex> lock(result_mutex);
+                if (!ok)
+                {
+                    failures++;
+                    std::cerr << ">>> " << (pair.name.empty() ? "input" : pair.name) << ": " << frame_error
+                              << std::endl;
+                    frame_error.clear();
+                    continue;
+                }
+                frames++;
+                total_pixels += (double)config.rows * config.cols * run.repeat;
+                total_load_ms += load_ms;
+                latencies_ms.insert(latencies_ms.end(), run_ms.begin(), run_ms.end());
+                for (size_t r = 0; r < run_levels.size(); r++)
+                    level_runs[run_levels[r]]++;
+                if (run.verbose)
+                    std::printf("%-32s %4dx%-4d load %8.2f ms  compute %8.2f ms  level %d\n", pair.name.c_str(),
+                                config.cols, config.rows, load_ms, run_ms.back(), run_levels.back());
+            }
+            sgm_destroy_workspace(workspace);
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    double sum_ms = 0.0;
+    for (size_t i = 0; i < latencies_ms.size(); i++)
+        sum_ms += latencies_ms[i];
+    size_t runs = latencies_ms.size();
+
+    std::printf(">>> Processed %d frame(s), %d failed, %zu engine run(s) in %.3f s: %.2f runs/s, %.2f Mpix/s\n",
+                frames, failures, runs, wall_s, runs / wall_s, total_pixels / wall_s / 1e6);
+    if (runs > 0)
+        std::printf(">>> Run latency ms: mean %.3f, p50 %.3f, p99 %.3f, max %.3f; mean load %.3f ms/frame\n",
+                    sum_ms / runs, percentile(latencies_ms, 0.5), percentile(latencies_ms, 0.99), latencies_ms.back(),
+                    total_load_ms / frames);
+    if (run.budget_ms > 0 && runs > 0)
+    {
+        std::printf(">>> Quality levels within %d ms:", run.budget_ms);
+        for (int level = 0; level < SGM_QUALITY_MAX_LEVELS; level++)
+            if (level_runs[level] > 0)
+                std::printf(" L%d %ld run(s)", level, level_runs[level]);
+        std::printf("\n");
+    }
+    if (!run.output_dir.empty())
+        std::cout << ">>> Disparity maps saved to: " << run.output_dir << std::endl;
+
+#ifdef SGM_PROFILE
+    std::cout << ">>> Stage Profile:" << std::endl;
+    sgm_profiler::instance().report(std::cout);
+#endif
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#include "sgm_hls.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <memory>
+#include <new>
+#include <string>
+
+/**
+ * @file sgm_python.cpp
+ * @brief Python module `sgm`: the C++ engine on NumPy arrays without copies.
+ *
+ * Frames are C-contiguous float32 arrays of shape (rows, cols) (uint8 (rows, cols, 3) for the color cost),
+ * disparities int32 (rows, cols). Arguments are bound with noconvert(), so the engine reads the caller's
+ * buffers in place and a wrong dtype or layout raises TypeError instead of silently copying; convert once
+ * with np.ascontiguousarray(image, dtype=np.float32). Results are written straight into a new or caller-
+ * provided array. The GIL is released while the engine runs, so several Engine objects (each with its own
+ * workspace) can compute concurrently from Python threads.
+ */
+
+namespace py = pybind11;
+
+typedef py::array_t<float, py::array::c_style> float_frame;
+typedef py::array_t<unsigned char, py::array::c_style> rgb_frame;
+typedef py::array_t<int, py::array::c_style> disparity_frame;
+
+/**
+ * @brief Throws ValueError unless @p frame has shape (rows, cols) or (rows, cols, channels).
+ */
+static void check_shape(const py::array &frame, const sgm_config_t &config, int channels, const char *name)
+{
+    bool match = frame.ndim() == (channels > 1 ? 3 : 2) && frame.shape(0) == config.rows &&
+                 frame.shape(1) == config.cols && (channels == 1 || frame.shape(2) == channels);
+    if (!match)
+    {
+        throw py::value_error(std::string(name) + " must have shape (" + std::to_string(config.rows) + ", " +
+                              std::to_string(config.cols) + (channels > 1 ? ", 3)" : ")"));
+    }
+}
+
+/**
+ * @brief One engine instance: a validated configuration and its own workspace.
+ */
+class sgm_engine
+{
+public:
+    explicit sgm_engine(const sgm_config_t &config) : config(config), workspace(0, sgm_destroy_workspace)
+    {
+        if (sgm_check_config(config) != 0)
+            throw py::value_error("invalid SGM configuration for the compiled maxima");
+        workspace.reset(sgm_create_workspace(config));
+        if (!workspace)
+            throw std::bad_alloc();
+    }
+
+    disparity_frame compute(const float_frame &left, const float_frame &right, py::object out)
+    {
+        check_shape(left, config, 1, "left");
+        check_shape(right, config, 1, "right");
+        disparity_frame target = output(out);
+        const float *left_pixels = left.data();
+        const float *right_pixels = right.data();
+        int *disparity = target.mutable_data();
+        {
+            py::gil_scoped_release release;
+            sgm_compute(config, left_pixels, right_pixels, disparity, *workspace);
+        }
+        return target;
+    }
+
+    disparity_frame compute_hmi(const float_frame &left, const float_frame &right, py::object out)
+    {
+        check_shape(left, config, 1, "left");
+        check_shape(right, config, 1, "right");
+        disparity_frame target = output(out);
+        sgm_config_t reserved = config; // HMI matches with the MI table whatever config.cost is
+        reserved.cost = SGM_COST_MI;
+        if (sgm_reserve_workspace(*workspace, reserved) != 0)
+            throw std::bad_alloc();
+        const float *left_pixels = left.data();
+        const float *right_pixels = right.data();
+        int *disparity = target.mutable_data();
+        {
+            py::gil_scoped_release release;
+            sgm_compute_hmi(config, left_pixels, right_pixels, disparity, *workspace);
+        }
+        return target;
+    }
+
+    disparity_frame compute_rgb(const rgb_frame &left, const rgb_frame &right, py::object out)
+    {
+        if (sgm_check_rgb_config(config) != 0)
+            throw py::value_error("configuration does not support the color cost");
+        check_shape(left, config, SGM_RGB_CHANNELS, "left");
+        check_shape(right, config, SGM_RGB_CHANNELS, "right");
+        disparity_frame target = output(out);
+        const unsigned char *left_rgb = left.data();
+        const unsigned char *right_rgb = right.data();
+        int *disparity = target.mutable_data();
+        {
+            py::gil_scoped_release release;
+            sgm_compute_rgb(config, left_rgb, right_rgb, disparity, *workspace);
+        }
+        return target;
+    }
+
+    sgm_config_t get_config() const
+    {
+        return config;
+    }
+
+private:
+    /**
+     * @brief The caller's int32 (rows, cols) array, or a new one when @p out is None.
+     */
+    disparity_frame output(py::object out) const
+    {
+        if (out.is_none())
+            return disparity_frame({(py::ssize_t)config.rows, (py::ssize_t)config.cols});
+        if (!py::isinstance<disparity_frame>(out))
+            throw py::type_error("out must be a C-contiguous int32 array");
+        disparity_frame target = py::reinterpret_borrow<disparity_frame>(out);
+        check_shape(target, config, 1, "out");
+        if (!target.writeable())
+            throw py::value_error("out is read-only");
+        return target;
+    }
+
+    sgm_config_t config;
+    std::unique_ptr<sgm_workspace_t, void (*)(sgm_workspace_t *)> workspace;
+};
+
+PYBIND11_MODULE(sgm, m)
+{
+    m.doc() = "Semi-global matching engine (zero-copy NumPy interface)";
+    m.attr("HEIGHT") = HEIGHT;
+    m.attr("WIDTH") = WIDTH;
+    m.attr("MAX_DISP") = MAX_DISP;
+    m.attr("COST_AD") = SGM_COST_AD;
+    m.attr("COST_MI") = SGM_COST_MI;
+
+    py::class_<sgm_config_t>(m, "Config", "Runtime configuration (sgm_config_t), initialized to sgm_default_config()")
+        .def(py::init([]() { return sgm_default_config(); }))
+        .def_readwrite("rows", &sgm_config_t::rows)
+        .def_readwrite("cols", &sgm_config_t::cols)
+        .def_readwrite("disp_range", &sgm_config_t::disp_range)
+        .def_readwrite("num_paths", &sgm_config_t::num_paths)
+        .def_readwrite("subsample", &sgm_config_t::subsample)
+        .def_readwrite("p1", &sgm_config_t::p1)
+        .def_readwrite("p2", &sgm_config_t::p2)
+        .def_readwrite("compress_step", &sgm_config_t::compress_step)
+        .def_readwrite("recompute_cost", &sgm_config_t::recompute_cost)
+        .def_readwrite("single_sweep", &sgm_config_t::single_sweep)
+        .def_readwrite("memory_bounded", &sgm_config_t::memory_bounded)
+        .def_readwrite("mgm", &sgm_config_t::mgm)
+        .def_readwrite("cost", &sgm_config_t::cost)
+        .def("is_valid", [](const sgm_config_t &config) { return sgm_check_config(config) == 0; });
+
+    py::class_<sgm_engine>(m, "Engine", "Engine with its own workspace; one compute() at a time per instance")
+        .def(py::init<const sgm_config_t &>(), py::arg("config") = sgm_default_config())
+        .def_property_readonly("config", &sgm_engine::get_config)
+        .def("compute", &sgm_engine::compute, "Disparity map of a float32 (rows, cols) pair",
+             py::arg("left").noconvert(), py::arg("right").noconvert(), py::arg("out") = py::none())
+        .def("compute_hmi", &sgm_engine::compute_hmi, "Disparity map with the hierarchical mutual-information cost",
+             py::arg("left").noconvert(), py::arg("right").noconvert(), py::arg("out") = py::none())
+        .def("compute_rgb", &sgm_engine::compute_rgb, "Disparity map of a uint8 (rows, cols, 3) RGB pair",
+             py::arg("left").noconvert(), py::arg("right").noconvert(), py::arg("out") = py::none());
+}
@@ -0,0 +1,55 @@
+#include "disparity_server.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/**
+ * @file sgm_server.cpp
+ * @brief Disparity daemon: serves sgm_disparity_client requests until SIGINT / SIGTERM.
+ *
+ * Usage: sgm_server [socket_path] [workers] [max_batch]
+ */
+
+#ifndef SGM_SERVER_SOCKET
+#define SGM_SERVER_SOCKET "/tmp/sgm_disparity.sock"
+#endif
+
+static sgm_disparity_server *active_server = 0;
+
+static void handle_signal(int)
+{
+    if (active_server)
+        active_server->request_stop();
+}
+
+int main(int argc, char **argv)
+{
+    std::string socket_path = (argc > 1) ? argv[1] : SGM_SERVER_SOCKET;
+    unsigned hardware_threads = std::thread::hardware_concurrency();
+    int workers = (argc > 2) ? std::atoi(argv[2]) : (int)(hardware_threads > 0 ? hardware_threads : 1);
+    int max_batch = (argc > 3) ? std::atoi(argv[3]) : 4;
+
+    sgm_disparity_server server;
+    std::string error;
+    if (!server.start(socket_path, workers, max_batch, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    active_server = &server;
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+    std::cout << ">>> SGM disparity server on " << socket_path << ": " << workers << " worker(s), batches of up to "
+              << max_batch << ", engine maxima " << WIDTH << "x" << HEIGHT << "x" << MAX_DISP << std::endl;
+
+    server.run();
+    active_server = 0;
+
+    uint64_t requests, batches;
+    server.statistics(requests, batches);
+    std::cout << ">>> Served " << requests << " request(s) in " << batches << " batch(es)." << std::endl;
+    return 0;
+}
@@ -0,0 +1,303 @@
+#include "shm_ring.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file shm_ring.cpp
+ * @brief shm_open / mmap lifecycle and the lock-free index protocol of sgm_shm_ring, and the engine loop
+ * that serves frames from one ring into another.
+ */
+
+#define SGM_SHM_SPIN_ITERATIONS 1024 // Busy polls before yielding the core
+
+static size_t header_bytes()
+{
+    return (sizeof(sgm_shm_ring_header) + SGM_SHM_ALIGN - 1) / SGM_SHM_ALIGN * SGM_SHM_ALIGN;
+}
+
+sgm_shm_ring::sgm_shm_ring()
+    : owner(false), mapped_bytes(0), header(0), slots(0), cached_head(0), cached_tail(0)
+{
+}
+
+sgm_shm_ring::~sgm_shm_ring()
+{
+    close();
+}
+
+bool sgm_shm_ring::map(int fd, size_t bytes, std::string &error)
+{
+    void *base = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        error = "mmap failed for " + shm_name + ": " + std::strerror(errno);
+        return false;
+    }
+    mapped_bytes = bytes;
+    header = (sgm_shm_ring_header *)base;
+    slots = (unsigned char *)base + header_bytes();
+    return true;
+}
+
+bool sgm_shm_ring::create(const std::string &name, uint32_t slot_count, uint64_t slot_bytes, std::string &error)
+{
+    close();
+    if (slot_count == 0 || slot_bytes == 0 || slot_bytes > (SIZE_MAX - 2 * header_bytes()) / slot_count)
+    {
+        error = "shm ring " + name + ": slot count and size must be positive and fit the address space";
+        return false;
+    }
+
+    shm_name = name;
+    slot_bytes = (slot_bytes + SGM_SHM_ALIGN - 1) / SGM_SHM_ALIGN * SGM_SHM_ALIGN;
+    size_t bytes = header_bytes() + (size_t)slot_count * slot_bytes;
+
+    shm_unlink(name.c_str()); // Stale object from a crashed run
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        error = "shm_open failed for " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0)
+    {
+        error = "ftruncate failed for " + name + ": " + std::strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    if (!map(fd, bytes, error))
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+    owner = true;
+
+    header = new (header) sgm_shm_ring_header;
+    header->slot_count = slot_count;
+    header->slot_bytes = slot_bytes;
+    header->reserved = 0;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_relaxed);
+    header->version = SGM_SHM_RING_VERSION;
+    // Publish the magic last so an attaching process never sees a half-initialized header
+    header->magic.store(SGM_SHM_RING_MAGIC, std::memory_order_release);
+    return true;
+}
+
+bool sgm_shm_ring::open(const std::string &name, std::string &error)
+{
+    close();
+    shm_name = name;
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+    {
+        error = "shm_open failed for " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < header_bytes())
+    {
+        error = "shm ring " + name + " is truncated";
+        ::close(fd);
+        return false;
+    }
+    if (!map(fd, (size_t)info.st_size, error))
+        return false;
+
+    // slot_count or slot_bytes of 0 would make slot() divide by zero; the product must fit the mapping
+    if (header->magic.load(std::memory_order_acquire) != SGM_SHM_RING_MAGIC ||
+        header->version != SGM_SHM_RING_VERSION || header->slot_count == 0 || header->slot_bytes == 0 ||
+        header->slot_bytes > (mapped_bytes - header_bytes()) / header->slot_count)
+    {
+        error = "shm ring " + name + " has an incompatible layout";
+        close();
+        return false;
+    }
+    cached_head = header->head.load(std::memory_order_acquire);
+    cached_tail = header->tail.load(std::memory_order_acquire);
+    return true;
+}
+
+void sgm_shm_ring::close()
+{
+    if (header)
+        munmap((void *)header, mapped_bytes);
+    if (owner)
+        shm_unlink(shm_name.c_str());
+    owner = false;
+    mapped_bytes = 0;
+    header = 0;
+    slots = 0;
+    cached_head = cached_tail = 0;
+}
+
+unsigned char *sgm_shm_ring::slot(uint64_t index) const
+{
+    return slots + (size_t)(index % header->slot_count) * header->slot_bytes;
+}
+
+void *sgm_shm_ring::acquire_write()
+{
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    if (head - cached_tail >= header->slot_count)
+    {
+        // Only touch the consumer's cache line when the cached view says the ring is full
+        cached_tail = header->tail.load(std::memory_order_acquire);
+        if (head - cached_tail >= header->slot_count)
+            return 0;
+    }
+    return slot(head);
+}
+
+void sgm_shm_ring::commit_write()
+{
+    header->head.store(header->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void *sgm_shm_ring::acquire_read()
+{
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    if (tail == cached_head)
+    {
+        cached_head = header->head.load(std::memory_order_acquire);
+        if (tail == cached_head)
+            return 0;
+    }
+    return slot(tail);
+}
+
+void sgm_shm_ring::release_read()
+{
+    header->tail.store(header->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void sgm_shm_ring::mark_closed()
+{
+    header->closed.store(1, std::memory_order_release);
+}
+
+bool sgm_shm_ring::drained() const
+{
+    // Read closed before head: a producer commits its last slot before closing
+    return header->closed.load(std::memory_order_acquire) != 0 &&
+           header->tail.load(std::memory_order_relaxed) == header->head.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Yields once past the spin phase; false when the wait has exceeded @p timeout_ns.
+ * The clock is only read while yielding, so short waits stay pure polls.
+ */
+static bool keep_waiting(int spin, int64_t timeout_ns, std::chrono::steady_clock::time_point &deadline)
+{
+    if (spin < SGM_SHM_SPIN_ITERATIONS)
+        return true;
+    if (timeout_ns >= 0)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (spin == SGM_SHM_SPIN_ITERATIONS)
+            deadline = now + std::chrono::nanoseconds(timeout_ns);
+        else if (now >= deadline)
+            return false;
+    }
+    sched_yield();
+    return true;
+}
+
+void *sgm_shm_wait_write(sgm_shm_ring &ring, int64_t timeout_ns)
+{
+    std::chrono::steady_clock::time_point deadline;
+    for (int spin = 0;; spin += (spin <= SGM_SHM_SPIN_ITERATIONS)) // Saturates once yielding
+    {
+        void *slot = ring.acquire_write();
+        if (slot)
+            return slot;
+        if (!keep_waiting(spin, timeout_ns, deadline))
+            return 0; // The consumer released nothing for timeout_ns: presumed dead
+    }
+}
+
+void *sgm_shm_wait_read(sgm_shm_ring &ring, int64_t timeout_ns)
+{
+    std::chrono::steady_clock::time_point deadline;
+    for (int spin = 0;; spin += (spin <= SGM_SHM_SPIN_ITERATIONS)) // Saturates once yielding
+    {
+        void *slot = ring.acquire_read();
+        if (slot)
+            return slot;
+        if (ring.drained())
+            return 0;
+        if (!keep_waiting(spin, timeout_ns, deadline))
+            return 0; // The producer published nothing and did not close the ring
+    }
+}
+
+bool sgm_shm_serve(sgm_shm_ring &input, sgm_shm_ring &output, const sgm_config_t &config,
+                   sgm_workspace_t &workspace, sgm_shm_serve_stats &stats, std::string &error, int64_t timeout_ns)
+{
+    stats = sgm_shm_serve_stats();
+    if (input.slot_bytes() < SGM_SHM_INPUT_SLOT_BYTES || output.slot_bytes() < SGM_SHM_OUTPUT_SLOT_BYTES)
+    {
+        error = "shm rings are not open or their slots cannot hold a " + std::to_string(WIDTH) + "x" +
+                std::to_string(HEIGHT) + " frame";
+        return false;
+    }
+
+    bool ok = true;
+    while (void *in = sgm_shm_wait_read(input, timeout_ns))
+    {
+        const sgm_shm_frame *frame = sgm_shm_frame_of(in);
+        void *out = sgm_shm_wait_write(output, timeout_ns);
+        if (!out)
+        {
+            error = "capture process stopped reading results";
+            ok = false;
+            break;
+        }
+        sgm_shm_frame *result = sgm_shm_frame_of(out);
+
+        sgm_config_t frame_config = config;
+        frame_config.rows = frame->rows;
+        frame_config.cols = frame->cols;
+        result->sequence = frame->sequence;
+        result->timestamp_ns = frame->timestamp_ns;
+        result->rows = frame->rows;
+        result->cols = frame->cols;
+        result->status = SGM_SHM_STATUS_OK;
+        if (sgm_check_config(frame_config) != 0)
+            result->status = SGM_SHM_STATUS_CONFIG;
+        else if (sgm_reserve_workspace(workspace, frame_config) != 0)
+            result->status = SGM_SHM_STATUS_MEMORY;
+        else if (config.cost == SGM_COST_MI)
+            sgm_compute_hmi(frame_config, sgm_shm_left_plane(in), sgm_shm_right_plane(in),
+                            sgm_shm_disparity_plane(out), workspace);
+        else
+            sgm_compute(frame_config, sgm_shm_left_plane(in), sgm_shm_right_plane(in), sgm_shm_disparity_plane(out),
+                        workspace);
+
+        stats.latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch()).count() - frame->timestamp_ns;
+        stats.frames++;
+        stats.failed += result->status != SGM_SHM_STATUS_OK;
+        output.commit_write();
+        input.release_read();
+    }
+    if (ok && !input.drained())
+    {
+        error = "capture process stopped publishing frames without closing the ring";
+        ok = false;
+    }
+    output.mark_closed();
+    return ok;
+}
@@ -0,0 +1,165 @@
+#ifndef SGM_SHM_RING_H
+#define SGM_SHM_RING_H
+
+#include "sgm_hls.h"
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+/**
+ * @file shm_ring.h
+ * @brief POSIX shared-memory ring buffers for zero-copy frame exchange with a capture process.
+ *
+ * A ring is one shm object: a control header followed by slot_count fixed-size slots. One process
+ * produces, one consumes; the only synchronization is a pair of monotonically increasing indices
+ * (acquire/release atomics, no locks), so the engine reads stereo planes in place and writes
+ * disparity straight into the output ring (sgm_shm_serve). A full ring makes the producer back off; a
+ * closed and drained ring ends the consumer.
+ */
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "shm_ring requires lock-free 64-bit atomics to share indices between processes"
+#endif
+
+#define SGM_SHM_RING_MAGIC 0x53474d52u // "SGMR"
+#define SGM_SHM_RING_VERSION 1
+#define SGM_SHM_ALIGN 64               // Cache line: keeps indices and planes on separate lines
+#define SGM_SHM_WAIT_TIMEOUT_NS 5000000000LL // Default wait for the peer before it is presumed dead (5 s)
+
+/* --- Frame slot layout (input ring: header + left plane + right plane, output ring: header + disparity) --- */
+#define SGM_SHM_FRAME_HEADER_BYTES SGM_SHM_ALIGN
+#define SGM_SHM_PLANE_BYTES(type) ((((size_t)HEIGHT * WIDTH * sizeof(type)) + SGM_SHM_ALIGN - 1) / SGM_SHM_ALIGN * SGM_SHM_ALIGN)
+#define SGM_SHM_INPUT_SLOT_BYTES (SGM_SHM_FRAME_HEADER_BYTES + 2 * SGM_SHM_PLANE_BYTES(float))
+#define SGM_SHM_OUTPUT_SLOT_BYTES (SGM_SHM_FRAME_HEADER_BYTES + SGM_SHM_PLANE_BYTES(int))
+
+/* --- Output frame status --- */
+#define SGM_SHM_STATUS_OK 0
+#define SGM_SHM_STATUS_CONFIG -1 // sgm_check_config rejected the frame geometry; the plane is not written
+#define SGM_SHM_STATUS_MEMORY -2 // Workspace buffers of the configuration could not be allocated
+
+/**
+ * @brief Per-frame metadata at the start of every slot. Planes are rows x cols, row-major, packed.
+ */
+struct sgm_shm_frame
+{
+    uint64_t sequence;  // Producer frame counter, echoed into the matching disparity slot
+    int64_t timestamp_ns; // steady_clock (CLOCK_MONOTONIC), comparable across processes
+    int32_t rows;
+    int32_t cols;
+    int32_t status;     // 0 ok; output ring: SGM_SHM_STATUS_* of the frame
+    int32_t reserved;
+};
+
+/**
+ * @brief Control block at offset 0 of the shm object.
+ */
+struct sgm_shm_ring_header
+{
+    std::atomic<uint32_t> magic; // Stored last with release: the header is complete once it reads valid
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t reserved;
+    uint64_t slot_bytes;
+    alignas(SGM_SHM_ALIGN) std::atomic<uint64_t> head; // Slots published by the producer
+    alignas(SGM_SHM_ALIGN) std::atomic<uint64_t> tail; // Slots released by the consumer
+    alignas(SGM_SHM_ALIGN) std::atomic<uint32_t> closed; // Producer finished; consumer stops once drained
+};
+
+/**
+ * @brief Single-producer / single-consumer view of a shared-memory ring.
+ *
+ * Each process maps the ring once and uses it in exactly one role. Slot pointers stay valid until
+ * the matching commit / release call.
+ */
+class sgm_shm_ring
+{
+public:
+    sgm_shm_ring();
+    ~sgm_shm_ring();
+
+    /** @brief Creates (or recreates) the shm object @p name, e.g. "/sgm_frames". */
+    bool create(const std::string &name, uint32_t slot_count, uint64_t slot_bytes, std::string &error);
+
+    /** @brief Maps an existing ring created by another process. */
+    bool open(const std::string &name, std::string &error);
+
+    /** @brief Unmaps the ring; the creator also removes the shm name. */
+    void close();
+
+    /** @return Next free slot, or 0 when the ring is full (consumer lagging). */
+    void *acquire_write();
+    void commit_write();
+
+    /** @return Oldest published slot, or 0 when the ring is empty. */
+    void *acquire_read();
+    void release_read();
+
+    /** @brief Marks the stream finished (producer side). */
+    void mark_closed();
+
+    /** @return True once the producer closed the ring and every slot was consumed. */
+    bool drained() const;
+
+    uint32_t slot_count() const { return header ? header->slot_count : 0; }
+    uint64_t slot_bytes() const { return header ? header->slot_bytes : 0; }
+
+private:
+    sgm_shm_ring(const sgm_shm_ring &);
+    sgm_shm_ring &operator=(const sgm_shm_ring &);
+
+    bool map(int fd, size_t bytes, std::string &error);
+    unsigned char *slot(uint64_t index) const;
+
+    std::string shm_name;
+    bool owner;
+    size_t mapped_bytes;
+    sgm_shm_ring_header *header;
+    unsigned char *slots;
+    uint64_t cached_head; // Last index seen from the other side, refreshed only when needed
+    uint64_t cached_tail;
+};
+
+/* --- Slot accessors for the frame layouts --- */
+inline sgm_shm_frame *sgm_shm_frame_of(void *slot) { return (sgm_shm_frame *)slot; }
+inline float *sgm_shm_left_plane(void *slot) { return (float *)((unsigned char *)slot + SGM_SHM_FRAME_HEADER_BYTES); }
+inline float *sgm_shm_right_plane(void *slot)
+{
+    return (float *)((unsigned char *)slot + SGM_SHM_FRAME_HEADER_BYTES + SGM_SHM_PLANE_BYTES(float));
+}
+inline int *sgm_shm_disparity_plane(void *slot) { return (int *)((unsigned char *)slot + SGM_SHM_FRAME_HEADER_BYTES); }
+
+/**
+ * @brief Blocks (spin, then yield) until a slot can be written / read, or @p timeout_ns passes without
+ * the peer moving its index (a crashed consumer / producer never would). A negative timeout waits forever.
+ * @return 0 on timeout, or if the ring was closed and drained while waiting for a read slot (drained()
+ * tells the two apart).
+ */
+void *sgm_shm_wait_write(sgm_shm_ring &ring, int64_t timeout_ns = SGM_SHM_WAIT_TIMEOUT_NS);
+void *sgm_shm_wait_read(sgm_shm_ring &ring, int64_t timeout_ns = SGM_SHM_WAIT_TIMEOUT_NS);
+
+/**
+ * @brief Counters of one sgm_shm_serve run.
+ */
+struct sgm_shm_serve_stats
+{
+    uint64_t frames;    // Frames answered on the output ring, failed ones included
+    uint64_t failed;    // Frames answered with a non-zero status
+    int64_t latency_ns; // Sum of capture-to-result latencies (timestamp_ns to output commit)
+};
+
+/**
+ * @brief Engine loop of the consumer side: computes every frame of @p input into @p output in place.
+ *
+ * Each input slot's left / right planes are passed to the engine as they are, and the disparity is written
+ * straight into the next output slot; sequence and timestamp are echoed. @p config supplies every engine
+ * setting except rows / cols, which come from the frame header (cost = MI runs sgm_compute_hmi). The
+ * loop ends when the producer closes @p input and every frame has been answered; @p output is then closed
+ * too, and it is also closed when the loop gives up.
+ * @return False with @p error when the rings do not hold full frames, or when the capture process stops
+ * publishing or reading for @p timeout_ns (negative: wait forever).
+ */
+bool sgm_shm_serve(sgm_shm_ring &input, sgm_shm_ring &output, const sgm_config_t &config,
+                   sgm_workspace_t &workspace, sgm_shm_serve_stats &stats, std::string &error,
+                   int64_t timeout_ns = SGM_SHM_WAIT_TIMEOUT_NS);
+
+#endif
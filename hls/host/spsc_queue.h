@@ -0,0 +1,96 @@
+#ifndef SGM_SPSC_QUEUE_H
+#define SGM_SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+
+/**
+ * @file spsc_queue.h
+ * @brief Bounded lock-free single-producer / single-consumer ring for handing frames between stage threads.
+ *
+ * Exactly one thread pushes and one thread pops. Each side owns one index and keeps a cached copy of the
+ * other, so a handoff normally touches one shared cache line: no mutex, no system call. A full queue
+ * rejects try_push (backpressure on the upstream stage); push() and pop() spin, then yield.
+ */
+
+#define SGM_SPSC_CACHE_LINE 64
+#define SGM_SPSC_SPIN_ITERATIONS 256 // Busy polls before yielding the core
+
+/**
+ * @tparam T         Element type, typically a frame handle (pointer).
+ * @tparam CAPACITY  Slot count; a power of two so the index wraps with a mask.
+ */
+template <typename T, size_t CAPACITY>
+class sgm_spsc_queue
+{
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    sgm_spsc_queue() : head(0), tail(0), cached_tail(0), cached_head(0) {}
+
+    /** @return False when the queue is full. Producer thread only. */
+    bool try_push(const T &item)
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position - cached_tail == CAPACITY)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (position - cached_tail == CAPACITY)
+                return false;
+        }
+        slots[position & (CAPACITY - 1)] = item;
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @return False when the queue is empty. Consumer thread only. */
+    bool try_pop(T &item)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position == cached_head)
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if (position == cached_head)
+                return false;
+        }
+        item = slots[position & (CAPACITY - 1)];
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Waits until the downstream stage frees a slot. */
+    void push(const T &item)
+    {
+        for (int spin = 0; !try_push(item); spin++)
+        {
+            if (spin >= SGM_SPSC_SPIN_ITERATIONS)
+                std::this_thread::yield();
+        }
+    }
+
+    /** @brief Waits until the upstream stage delivers an item. */
+    T pop()
+    {
+        T item;
+        for (int spin = 0; !try_pop(item); spin++)
+        {
+            if (spin >= SGM_SPSC_SPIN_ITERATIONS)
+                std::this_thread::yield();
+        }
+        return item;
+    }
+
+private:
+    sgm_spsc_queue(const sgm_spsc_queue &);
+    sgm_spsc_queue &operator=(const sgm_spsc_queue &);
+
+    // Producer and consumer state on separate cache lines to avoid false sharing
+    alignas(SGM_SPSC_CACHE_LINE) std::atomic<size_t> head;
+    alignas(SGM_SPSC_CACHE_LINE) std::atomic<size_t> tail;
+    alignas(SGM_SPSC_CACHE_LINE) size_t cached_tail; // Producer's view of tail
+    alignas(SGM_SPSC_CACHE_LINE) size_t cached_head; // Consumer's view of head
+    alignas(SGM_SPSC_CACHE_LINE) T slots[CAPACITY];
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "stream_mux.h"
+
+#include <chrono>
+
+/**
+ * @file stream_mux.cpp
+ * @brief Stream contexts, fair-share / deadline scheduling and the worker pool of sgm_stream_mux.
+ */
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+sgm_stream_mux::sgm_stream_mux() : virtual_clock(0.0), pending(0), stopping(false)
+{
+}
+
+sgm_stream_mux::~sgm_stream_mux()
+{
+    stop();
+    for (size_t i = 0; i < workspaces.size(); i++)
+        sgm_destroy_workspace(workspaces[i]);
+}
+
+bool sgm_stream_mux::start(int worker_count, std::string &error)
+{
+    if (!workspaces.empty())
+    {
+        error = "stream multiplexer already started";
+        return false;
+    }
+    for (int w = 0; w < ((worker_count > 0) ? worker_count : 1); w++)
+    {
+        sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+        if (!workspace)
+        {
+            error = "cannot allocate worker workspaces";
+            return false;
+        }
+        workspaces.push_back(workspace);
+    }
+    stopping = false;
+    for (size_t w = 0; w < workspaces.size(); w++)
+        workers.push_back(std::thread(&sgm_stream_mux::worker_loop, this, workspaces[w]));
+    return true;
+}
+
+int sgm_stream_mux::add_stream(const sgm_stream_settings &settings, const sgm_frame_callback &done,
+                               std::string &error)
+{
+    if (sgm_check_config(settings.config) != 0)
+        error = "stream " + settings.name + ": engine configuration rejected";
+    else if (settings.weight < 1 || settings.weight > SGM_STREAM_MAX_WEIGHT)
+        error = "stream " + settings.name + ": weight must be 1 .. " + std::to_string(SGM_STREAM_MAX_WEIGHT);
+    else if (settings.queue_depth < 1 || settings.deadline_ns < 0)
+        error = "stream " + settings.name + ": queue_depth must be at least 1 and deadline_ns not negative";
+    else if (settings.degrade && settings.deadline_ns == 0)
+        error = "stream " + settings.name + ": degrade needs a deadline";
+    else
+    {
+        stream_context context;
+        if (settings.degrade && !context.governor.configure(settings.config, error))
+            return -1;
+        std::lock_guard<std::mutex> lock(mutex);
+        context.settings = settings;
+        context.done = done;
+        context.busy = false;
+        context.virtual_ns = virtual_clock;
+        context.stats = sgm_stream_stats();
+        streams.push_back(context);
+        return (int)streams.size() - 1;
+    }
+    return -1;
+}
+
+bool sgm_stream_mux::submit(int stream, uint64_t sequence, const float *left, const float *right, int *disparity,
+                            std::string &error)
+{
+    if (!left || !right || !disparity)
+    {
+        error = "null frame plane";
+        return false;
+    }
+
+    frame item;
+    item.sequence = sequence;
+    item.left = left;
+    item.right = right;
+    item.disparity = disparity;
+    item.arrival_ns = now_ns();
+
+    bool dropped = false;
+    frame oldest;
+    sgm_frame_callback done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stream < 0 || stream >= (int)streams.size())
+        {
+            error = "unknown stream " + std::to_string(stream);
+            return false;
+        }
+        if (stopping)
+        {
+            error = "stream multiplexer is stopped";
+            return false;
+        }
+        stream_context &context = streams[stream];
+        item.deadline_ns = context.settings.deadline_ns > 0 ? item.arrival_ns + context.settings.deadline_ns : INT64_MAX;
+
+        // An idle stream resumes at the pool's virtual time instead of spending credit saved while idle
+        if (context.queue.empty() && !context.busy && context.virtual_ns < virtual_clock)
+            context.virtual_ns = virtual_clock;
+
+        if ((int)context.queue.size() >= context.settings.queue_depth)
+        {
+            oldest = context.queue.front();
+            context.queue.pop_front();
+            context.stats.dropped++;
+            done = context.done;
+            dropped = true;
+        }
+        else
+            pending++;
+        context.queue.push_back(item);
+    }
+    work_ready.notify_one();
+
+    if (dropped && done)
+    {
+        sgm_frame_result result = sgm_frame_result();
+        result.stream = stream;
+        result.sequence = oldest.sequence;
+        result.status = SGM_FRAME_DROPPED;
+        result.disparity = oldest.disparity;
+        done(result);
+    }
+    return true;
+}
+
+int sgm_stream_mux::pick_stream() const
+{
+    double minimum = 0.0;
+    bool any = false;
+    for (size_t s = 0; s < streams.size(); s++)
+    {
+        const stream_context &context = streams[s];
+        if (!context.busy && !context.queue.empty() && (!any || context.virtual_ns < minimum))
+        {
+            minimum = context.virtual_ns;
+            any = true;
+        }
+    }
+    if (!any)
+        return -1;
+
+    // Earliest deadline among the streams that have not run ahead of their share
+    int best = -1;
+    for (size_t s = 0; s < streams.size(); s++)
+    {
+        const stream_context &context = streams[s];
+        if (context.busy || context.queue.empty() || context.virtual_ns > minimum + SGM_STREAM_FAIR_SLACK_NS)
+            continue;
+        if (best < 0)
+        {
+            best = (int)s;
+            continue;
+        }
+        const stream_context &chosen = streams[best];
+        int64_t deadline = context.queue.front().deadline_ns, chosen_deadline = chosen.queue.front().deadline_ns;
+        if (deadline < chosen_deadline || (deadline == chosen_deadline && context.virtual_ns < chosen.virtual_ns))
+            best = (int)s;
+    }
+    return best;
+}
+
+void sgm_stream_mux::worker_loop(sgm_workspace_t *workspace)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        int stream;
+        work_ready.wait(lock, [&] { return (stream = pick_stream()) >= 0 || (stopping && pending == 0); });
+        if (stream < 0)
+            return;
+
+        stream_context &context = streams[stream];
+        frame item = context.queue.front();
+        context.queue.pop_front();
+        context.busy = true;
+        if (context.virtual_ns > virtual_clock)
+            virtual_clock = context.virtual_ns;
+        sgm_config_t config = context.settings.config;
+        bool degrade = context.settings.degrade != 0;
+        sgm_frame_callback done = context.done;
+        lock.unlock();
+
+        sgm_frame_result result = sgm_frame_result();
+        result.stream = stream;
+        result.sequence = item.sequence;
+        result.status = SGM_FRAME_DONE;
+        result.disparity = item.disparity;
+        int64_t start_ns = now_ns();
+        result.queue_ns = start_ns - item.arrival_ns;
+        std::string reserve_error;
+        // The governor is only touched by the worker that holds the stream
+        bool reserved = degrade ? context.governor.reserve(*workspace, reserve_error)
+                                : sgm_reserve_workspace(*workspace, config) == 0;
+        if (!reserved)
+            result.status = SGM_FRAME_FAILED;
+        else if (degrade)
+            result.quality_level = context.governor.compute(item.deadline_ns - start_ns, item.left, item.right,
+                                                            item.disparity, *workspace);
+        else if (config.cost == SGM_COST_MI)
+            sgm_compute_hmi(config, item.left, item.right, item.disparity, *workspace);
+        else
+            sgm_compute(config, item.left, item.right, item.disparity, *workspace);
+        int64_t end_ns = now_ns();
+        result.compute_ns = end_ns - start_ns;
+        result.late = end_ns > item.deadline_ns;
+        if (done)
+            done(result);
+
+        lock.lock();
+        context.busy = false;
+        context.virtual_ns += (double)result.compute_ns / context.settings.weight;
+        if (result.status == SGM_FRAME_FAILED)
+            context.stats.failed++;
+        else
+        {
+            context.stats.frames++;
+            context.stats.level_frames[result.quality_level]++;
+        }
+        context.stats.late += result.late ? 1 : 0;
+        context.stats.compute_ns += result.compute_ns;
+        if (end_ns - item.arrival_ns > context.stats.max_latency_ns)
+            context.stats.max_latency_ns = end_ns - item.arrival_ns;
+        pending--;
+        // The stream may now be eligible again, and drain() / stop() may be waiting
+        work_ready.notify_all();
+        if (pending == 0)
+            idle.notify_all();
+    }
+}
+
+void sgm_stream_mux::drain()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending == 0 || workers.empty(); });
+}
+
+void sgm_stream_mux::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+}
+
+bool sgm_stream_mux::statistics(int stream, sgm_stream_stats &stats) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stream < 0 || stream >= (int)streams.size())
+        return false;
+    stats = streams[stream].stats;
+    return true;
+}
+
+bool sgm_stream_mux::quality_ladder(int stream, std::vector<sgm_config_t> &ladder) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stream < 0 || stream >= (int)streams.size())
+        return false;
+    const stream_context &context = streams[stream];
+    ladder.clear();
+    if (!context.settings.degrade)
+    {
+        ladder.push_back(context.settings.config);
+        return true;
+    }
+    for (int level = 0; level < context.governor.levels(); level++) // Fixed once the stream is added
+        ladder.push_back(context.governor.level(level));
+    return true;
+}
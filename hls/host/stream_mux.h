@@ -0,0 +1,168 @@
+#ifndef SGM_STREAM_MUX_H
+#define SGM_STREAM_MUX_H
+
+#include "sgm_hls.h"
+#include "quality_governor.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file stream_mux.h
+ * @brief Several independent camera streams multiplexed onto one worker pool.
+ *
+ * Each stream context holds its own geometry and engine settings, a bounded frame queue and statistics.
+ * Workers own the workspaces (created in start()). Before each frame the worker reserves the buffers of
+ * the stream's configuration (every quality level for a degrading stream), so a workspace holds the union
+ * of the modes it has served and any worker can run any stream. A stream has at most one frame in
+ * computation, which keeps its completions in submission order and stops it from occupying more than one
+ * worker.
+ *
+ * When a worker becomes free the scheduler considers the streams with a queued frame:
+ * - Fair share: each stream accumulates virtual time, compute time divided by its weight. Only streams
+ *   within SGM_STREAM_FAIR_SLACK_NS of the smallest virtual time are eligible, so an expensive
+ *   high-resolution stream waits its turn once it has had its share.
+ * - Deadlines: among the eligible streams the earliest frame deadline (arrival + deadline_ns) wins.
+ * A stream that was idle resumes at the pool's current virtual time rather than with banked credit.
+ * A full stream queue drops its oldest frame, since live cameras prefer the newest image.
+ *
+ * A stream with `degrade` set runs each frame at the best quality level predicted to finish by the
+ * frame's deadline, measured from the start of its computation (quality_governor.h). A frame that has
+ * already queued past its deadline therefore runs at the cheapest level.
+ */
+
+#define SGM_STREAM_FAIR_SLACK_NS 20000000 // Virtual-time lead (20 ms) a stream may have and stay eligible
+#define SGM_STREAM_MAX_WEIGHT 64
+
+/* --- Frame completion status --- */
+#define SGM_FRAME_DONE 0
+#define SGM_FRAME_DROPPED 1 // Displaced from a full stream queue by a newer frame; never computed
+#define SGM_FRAME_FAILED 2  // The worker could not allocate the workspace buffers of the stream; never computed
+
+/**
+ * @brief Per-stream settings, fixed when the stream is added.
+ */
+struct sgm_stream_settings
+{
+    std::string name;
+    sgm_config_t config; // Geometry and engine options of this camera (SGM_COST_MI runs sgm_compute_hmi)
+    int64_t deadline_ns; // Completion deadline relative to submission; 0 for none (scheduled last)
+    int weight;          // Fair-share weight, 1 .. SGM_STREAM_MAX_WEIGHT
+    int queue_depth;     // Frames waiting before the oldest is dropped
+    int degrade;         // 1: step down the quality ladder to meet deadline_ns (AD cost, deadline required)
+};
+
+/**
+ * @brief Outcome of one submitted frame, passed to the stream's callback.
+ */
+struct sgm_frame_result
+{
+    int stream;
+    uint64_t sequence;
+    int status;         // SGM_FRAME_DONE, SGM_FRAME_DROPPED or SGM_FRAME_FAILED
+    int *disparity;     // Output plane given to submit()
+    int64_t queue_ns;   // Submission to start of computation
+    int64_t compute_ns;
+    bool late;          // Finished after its deadline
+    int quality_level;  // Ladder level the frame ran at (0 = stream configuration)
+};
+
+/**
+ * @brief Running totals of one stream.
+ */
+struct sgm_stream_stats
+{
+    uint64_t frames;  // Computed
+    uint64_t dropped;
+    uint64_t failed;  // SGM_FRAME_FAILED
+    uint64_t late;
+    int64_t compute_ns;
+    int64_t max_latency_ns; // Submission to completion
+    uint64_t level_frames[SGM_QUALITY_MAX_LEVELS]; // Computed frames per quality level
+};
+
+/**
+ * @brief Called on a worker thread after each computed frame (in submission order per stream), or on the
+ * submitting thread for a dropped frame. The planes of the frame may be reused once it returns.
+ */
+typedef std::function<void(const sgm_frame_result &)> sgm_frame_callback;
+
+class sgm_stream_mux
+{
+public:
+    sgm_stream_mux();
+    ~sgm_stream_mux();
+
+    /** @brief Creates one workspace per worker (buffers are reserved per stream) and starts the pool. */
+    bool start(int workers, std::string &error);
+
+    /**
+     * @brief Registers a stream; may be called while frames are running.
+     * @return Stream index for submit(), or -1 with @p error set.
+     */
+    int add_stream(const sgm_stream_settings &settings, const sgm_frame_callback &done, std::string &error);
+
+    /**
+     * @brief Queues a frame. The dense float planes and the int output plane (stream geometry) are
+     * caller-owned and must stay valid until the frame's callback. Frames submitted before start() wait
+     * for the workers.
+     */
+    bool submit(int stream, uint64_t sequence, const float *left, const float *right, int *disparity,
+                std::string &error);
+
+    /** @brief Blocks until every queued frame has completed. */
+    void drain();
+
+    /** @brief Drains, then joins the workers. */
+    void stop();
+
+    bool statistics(int stream, sgm_stream_stats &stats) const;
+
+    /** @brief Configurations of the stream's quality levels (only level 0 without degrade). */
+    bool quality_ladder(int stream, std::vector<sgm_config_t> &ladder) const;
+
+private:
+    struct frame
+    {
+        uint64_t sequence;
+        const float *left;
+        const float *right;
+        int *disparity;
+        int64_t arrival_ns;
+        int64_t deadline_ns; // Absolute; INT64_MAX without a deadline
+    };
+
+    struct stream_context
+    {
+        sgm_stream_settings settings;
+        sgm_frame_callback done;
+        std::deque<frame> queue;
+        bool busy;           // A frame of this stream is being computed
+        double virtual_ns;   // Compute time / weight
+        sgm_quality_governor governor; // Used by the worker running the stream's frame
+        sgm_stream_stats stats;
+    };
+
+    sgm_stream_mux(const sgm_stream_mux &);
+    sgm_stream_mux &operator=(const sgm_stream_mux &);
+
+    void worker_loop(sgm_workspace_t *workspace);
+    int pick_stream() const;
+
+    mutable std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable idle;
+    std::deque<stream_context> streams; // Deque: contexts keep their address as streams are added
+    std::vector<sgm_workspace_t *> workspaces;
+    std::vector<std::thread> workers;
+    double virtual_clock; // Virtual time of the most recently scheduled stream
+    int pending;          // Frames queued or running
+    bool stopping;
+};
+
+#endif
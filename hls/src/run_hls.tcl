@@ -10,7 +10,9 @@ set_top sgm_hls
 # tb_files: C-Simulation testbench
 add_files hls/src/sgm_hls.cpp
 add_files hls/src/sgm_hls.h
-add_files -tb hls/tb/main_tb.cpp
+add_files -tb hls/tb/main_tb.cpp -cflags "-Ihls/src -Ihls/host"
+add_files -tb hls/host/image_io.cpp
+add_files -tb hls/host/image_io.h
 
 # 3. Target Configuration
 # Targets the xc7z020 device with a 100MHz (10ns) clock constraint
@@ -20,7 +22,7 @@ create_clock -period 10 -name default
 
 # 4. Hardware Generation Flow
 # Run functional C-level simulation
-csim_design      
+csim_design -ldflags "-lz"
 
 # Perform High-Level Synthesis (C++ to RTL)
 csynth_design     
@@ -1,133 +1,1768 @@
 #include "sgm_hls.h"
+#include "sgm_profile.h"
+
+#ifndef __SYNTHESIS__
+#include <new>
+#endif
+
+/* --- Roofline Traffic Model (host profiling only) ---
+ * Compulsory off-chip bytes and arithmetic operations per stage, derived from geometry and data type.
+ * Evaluated only inside SGM_PROFILE_KERNEL, i.e. never during synthesis. */
+#define SGM_FRAME_PIXELS(rows, cols) ((double)(rows) * (cols))
+#define SGM_VOLUME_CELLS(rows, cols, disp) ((double)(rows) * (cols) * (disp))
+#define SGM_COST_OPS_PER_CELL 2      // subtract, abs
+#define SGM_AGGREGATE_OPS_PER_CELL 9 // prev-min compare, 3 penalty adds, 3 compares, normalize, accumulate
+#define SGM_WTA_OPS_PER_CELL 4       // 3 path additions, 1 compare
+#define SGM_MGM_OPS_PER_CELL (2 * SGM_AGGREGATE_OPS_PER_CELL + 2) // two predecessor steps, add, halve
+#define SGM_MI_COST_OPS_PER_CELL 2   // quantize, table lookup
+#define SGM_RGB_COST_OPS_PER_CELL 9  // 3 subtract, 3 abs, 2 add, scale
+#define SGM_RGB_COST_BYTES(rows, cols, disp) \
+    (2 * SGM_FRAME_PIXELS(rows, cols) * SGM_RGB_CHANNELS + SGM_VOLUME_CELLS(rows, cols, disp) * sizeof(float))
+#define SGM_COST_BYTES(rows, cols, disp, pixel_bytes) \
+    (2 * SGM_FRAME_PIXELS(rows, cols) * (pixel_bytes) + SGM_VOLUME_CELLS(rows, cols, disp) * sizeof(float))
+#define SGM_COST_INPUT_BYTES(rows, cols, disp, recompute) \
+    ((recompute) ? 2 * SGM_FRAME_PIXELS(rows, cols) * sizeof(float) : SGM_VOLUME_CELLS(rows, cols, disp) * sizeof(float))
+#define SGM_COST_INPUT_OPS(recompute) ((recompute) ? SGM_COST_OPS_PER_CELL : 0)
+#define SGM_AGGREGATE_BYTES(rows, cols, disp, recompute) \
+    (SGM_COST_INPUT_BYTES(rows, cols, disp, recompute) + SGM_VOLUME_CELLS(rows, cols, disp) * sizeof(float))
+#define SGM_WTA_BYTES(rows, cols, disp, paths) \
+    ((paths) * SGM_VOLUME_CELLS(rows, cols, disp) * sizeof(float) + SGM_FRAME_PIXELS(rows, cols) * sizeof(int))
+#define SGM_FORWARD_OPS_PER_CELL (4 * SGM_AGGREGATE_OPS_PER_CELL)      // 4 paths, summed in the accumulate step
+#define SGM_BACKWARD_OPS_PER_CELL (4 * SGM_AGGREGATE_OPS_PER_CELL + 1) // 4 paths + WTA compare
+#define SGM_SUM_BYTES_PER_CELL(disp, step) ((step) > 0 ? 1.0 + (double)sizeof(float) / (disp) : (double)sizeof(float))
+#define SGM_FORWARD_BYTES(rows, cols, disp, step, recompute) \
+    (SGM_COST_INPUT_BYTES(rows, cols, disp, recompute) + SGM_VOLUME_CELLS(rows, cols, disp) * SGM_SUM_BYTES_PER_CELL(disp, step))
+#define SGM_BACKWARD_BYTES(rows, cols, disp, step, recompute) \
+    (SGM_FORWARD_BYTES(rows, cols, disp, step, recompute) + SGM_FRAME_PIXELS(rows, cols) * sizeof(int))
+#define SGM_SINGLE_SWEEP_BYTES(rows, cols, disp, recompute) \
+    (SGM_COST_INPUT_BYTES(rows, cols, disp, recompute) + SGM_FRAME_PIXELS(rows, cols) * sizeof(int))
+#define SGM_CANDIDATE_BYTES (sizeof(short) + sizeof(float)) // One stored eSGM candidate per pixel
+#define SGM_MEMORY_BOUNDED_BYTES(rows, cols) \
+    (3 * SGM_COST_INPUT_BYTES(rows, cols, 0, 1) + 6 * SGM_FRAME_PIXELS(rows, cols) * SGM_CANDIDATE_BYTES + \
+     SGM_FRAME_PIXELS(rows, cols) * sizeof(int))
+
+/* --- Direction vectors (dy, dx) indexed by SGM_PATH_* --- */
+static const int path_dir_y[SGM_MAX_PATHS] = {0, 1, 0, -1};
+static const int path_dir_x[SGM_MAX_PATHS] = {1, 0, -1, 0};
+
+/* --- MGM quadrant sweeps (rows, columns): TL->BR, BR->TL, TR->BL, BL->TR; prefixes select 1/2/4 --- */
+static const int mgm_sweep_y[SGM_MAX_PATHS] = {1, -1, 1, -1};
+static const int mgm_sweep_x[SGM_MAX_PATHS] = {1, -1, -1, 1};
+
+sgm_config_t sgm_default_config()
+{
+    sgm_config_t config;
+    config.rows = HEIGHT;
+    config.cols = WIDTH;
+    config.disp_range = MAX_DISP;
+    config.num_paths = SGM_MAX_PATHS;
+    config.subsample = 1;
+    config.p1 = P1_PENALTY;
+    config.p2 = P2_PENALTY;
+    config.compress_step = 0;
+    config.recompute_cost = 0;
+    config.single_sweep = 0;
+    config.memory_bounded = 0;
+    config.mgm = 0;
+    config.cost = SGM_COST_AD;
+    return config;
+}
+
+int sgm_check_config(const sgm_config_t &config)
+{
+    if (config.rows < 1 || config.rows > HEIGHT || config.cols < 1 || config.cols > WIDTH)
+        return -1;
+    if (config.disp_range < 1 || config.disp_range > MAX_DISP)
+        return -1;
+    if (config.num_paths != 1 && config.num_paths != 2 && config.num_paths != 4 &&
+        config.num_paths != SGM_TWO_PASS_PATHS)
+        return -1;
+    if (config.subsample < 1 || config.rows / config.subsample < 1 || config.cols / config.subsample < 1)
+        return -1;
+    if (config.p1 < 0 || config.p2 < config.p1)
+        return -1;
+    if (config.compress_step < 0 || (config.compress_step > 0 && config.num_paths != SGM_TWO_PASS_PATHS))
+        return -1;
+    if (config.recompute_cost != 0 && config.recompute_cost != 1)
+        return -1;
+    if (config.single_sweep != 0 && (config.single_sweep != 1 || config.num_paths == SGM_TWO_PASS_PATHS))
+        return -1;
+    if (config.memory_bounded != 0 &&
+        (config.memory_bounded != 1 || config.num_paths != SGM_TWO_PASS_PATHS || config.compress_step != 0))
+        return -1;
+    if (config.cost != SGM_COST_AD &&
+        (config.cost != SGM_COST_MI || config.recompute_cost != 0 || config.memory_bounded != 0))
+        return -1;
+    if (config.mgm != 0 &&
+        (config.mgm != 1 || config.num_paths == SGM_TWO_PASS_PATHS || config.single_sweep != 0))
+        return -1;
+    return 0;
+}
 
 /**
- * @brief Computes the initial matching cost volume using Absolute Difference (AD).
- * @param left_pixels   Flat input array of the reference (left) grayscale image.
- * @param right_pixels  Flat input array of the target (right) grayscale image.
- * @param cost_volume   Output 3D tensor storing C(p, d) for all pixels and disparities.
+ * @brief Computes one row of the matching cost volume using Absolute Difference (AD). Pixels are read in
+ * place as pixel_t (8-bit, 16-bit or float): pixel (y, x) at image[y * stride + x], stride in pixels
+ * (cols for packed frames).
  */
-void compute_sad_cost_hls(
-    float left_pixels[HEIGHT * WIDTH],
-    float right_pixels[HEIGHT * WIDTH],
-    float cost_volume[HEIGHT][WIDTH][MAX_DISP])
+template <typename pixel_t>
+static void compute_sad_cost_row(
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int y, int cols, int disp_range)
 {
-    for (int y = 0; y < HEIGHT; y++)
+    const pixel_t *left_row = left_pixels + y * left_stride;
+    const pixel_t *right_row = right_pixels + y * right_stride;
+    for (int x = 0; x < cols; x++)
     {
-        for (int x = 0; x < WIDTH; x++)
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+        float left_sample = (float)left_row[x];
+        for (int d = 0; d < MAX_DISP; d++)
         {
+            // Verify target pixel remains within image boundaries and the active search range
+            if (x - d >= 0 && d < disp_range)
+            {
+                // Pixel-wise absolute difference calculation
+                cost_volume[y][x][d] = hls::fabs(left_sample - (float)right_row[x - d]);
+            }
+            else
+            {
+                // Assign maximum penalty for out-of-bounds disparity shifts
+                cost_volume[y][x][d] = 1000.0f;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Computes one row of the matching cost volume from interleaved 8-bit RGB: mean of the three
+ * per-channel absolute differences, so the cost keeps the 0..255 scale of the gray AD.
+ */
+static void compute_rgb_cost_row(
+    const unsigned char left_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    const unsigned char right_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int y, int cols, int disp_range)
+{
+    for (int x = 0; x < cols; x++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
 #pragma HLS PIPELINE II = 1
-            int pixel_idx = y * WIDTH + x;
-            for (int d = 0; d < MAX_DISP; d++)
+        const unsigned char *left = &left_rgb[(y * cols + x) * SGM_RGB_CHANNELS];
+        for (int d = 0; d < MAX_DISP; d++)
+        {
+            if (x - d >= 0 && d < disp_range)
             {
-                // Verify target pixel remains within image boundaries
-                if (x - d >= 0)
-                {
-                    // Pixel-wise absolute difference calculation
-                    cost_volume[y][x][d] = hls::fabs(left_pixels[pixel_idx] - right_pixels[y * WIDTH + (x - d)]);
-                }
-                else
+                const unsigned char *right = &right_rgb[(y * cols + x - d) * SGM_RGB_CHANNELS];
+                int sum = 0;
+                for (int c = 0; c < SGM_RGB_CHANNELS; c++)
                 {
-                    // Assign maximum penalty for out-of-bounds disparity shifts
-                    cost_volume[y][x][d] = 1000.0f;
+                    int diff = (int)left[c] - (int)right[c];
+                    sum += (diff < 0) ? -diff : diff;
                 }
+                cost_volume[y][x][d] = sum * (1.0f / SGM_RGB_CHANNELS);
+            }
+            else
+            {
+                // Assign maximum penalty for out-of-bounds disparity shifts
+                cost_volume[y][x][d] = 1000.0f;
             }
         }
     }
 }
 
+/**
+ * @brief Color matching cost volume (see compute_rgb_cost_row).
+ */
+void compute_rgb_cost_hls(
+    const unsigned char left_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    const unsigned char right_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int rows, int cols, int disp_range)
+{
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        compute_rgb_cost_row(left_rgb, right_rgb, cost_volume, y, cols, disp_range);
+    }
+}
+
+/**
+ * @brief MI table index of an intensity sample (rounded, clamped to 0..SGM_MI_LEVELS - 1).
+ */
+static int intensity_level(float sample)
+{
+#pragma HLS INLINE
+    int level = (int)(sample + 0.5f);
+    return (level < 0) ? 0 : (level >= SGM_MI_LEVELS) ? SGM_MI_LEVELS - 1 : level;
+}
+
+/**
+ * @brief Computes one row of the matching cost volume as gathered lookups C = mi_table[left][right]
+ * (image layout as in compute_sad_cost_row).
+ */
+template <typename pixel_t>
+static void compute_mi_cost_row(
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    float mi_table[SGM_MI_LEVELS][SGM_MI_LEVELS],
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int y, int cols, int disp_range)
+{
+    const pixel_t *left_row = left_pixels + y * left_stride;
+    const pixel_t *right_row = right_pixels + y * right_stride;
+    for (int x = 0; x < cols; x++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+        const float *table_row = mi_table[intensity_level((float)left_row[x])];
+        for (int d = 0; d < MAX_DISP; d++)
+        {
+            if (x - d >= 0 && d < disp_range)
+                cost_volume[y][x][d] = table_row[intensity_level((float)right_row[x - d])];
+            else
+                cost_volume[y][x][d] = 1000.0f;
+        }
+    }
+}
+
+/**
+ * @brief Mutual-information matching cost volume (see compute_mi_cost_row).
+ */
+template <typename pixel_t>
+void compute_mi_cost_hls(
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    float mi_table[SGM_MI_LEVELS][SGM_MI_LEVELS],
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int rows, int cols, int disp_range)
+{
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        compute_mi_cost_row(left_pixels, left_stride, right_pixels, right_stride, mi_table, cost_volume, y, cols,
+                            disp_range);
+    }
+}
+
+/**
+ * @brief Matching cost vector C(p, d) of pixel (y, x) recomputed from the image rows, read in place as in
+ * compute_sad_cost_row (same AD formula, no volume needed).
+ */
+template <typename pixel_t>
+static void recompute_pixel_cost(
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    int y, int x, int disp_range,
+    float cost[MAX_DISP])
+{
+    const pixel_t *right_row = right_pixels + y * right_stride;
+    float left_sample = (float)left_pixels[y * left_stride + x];
+    for (int d = 0; d < MAX_DISP; d++)
+    {
+        if (x - d >= 0 && d < disp_range)
+            cost[d] = hls::fabs(left_sample - (float)right_row[x - d]);
+        else
+            cost[d] = 1000.0f;
+    }
+}
+
+/**
+ * @brief Matching cost vector C(p, d) of pixel (y, x) for the aggregation kernels: read from the stored
+ * volume, or recomputed from the image rows.
+ */
+template <typename pixel_t>
+static void load_pixel_cost(
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    bool recompute, int y, int x, int disp_range,
+    float cost[MAX_DISP])
+{
+    if (recompute)
+    {
+        recompute_pixel_cost(left_pixels, left_stride, right_pixels, right_stride, y, x, disp_range, cost);
+        return;
+    }
+    for (int d = 0; d < MAX_DISP; d++)
+        cost[d] = cost_volume[y][x][d];
+}
+
+/**
+ * @brief Computes the initial matching cost volume using Absolute Difference (AD).
+ * @param left_pixels   Reference (left) grayscale image, read in place.
+ * @param left_stride   Pixels between rows of the left image (cols when packed).
+ * @param right_pixels  Target (right) grayscale image, read in place.
+ * @param right_stride  Pixels between rows of the right image.
+ * @param cost_volume   Output 3D tensor storing C(p, d) for all pixels and disparities.
+ * @param rows, cols, disp_range  Active geometry (within HEIGHT x WIDTH x MAX_DISP).
+ */
+template <typename pixel_t>
+void compute_sad_cost_hls(
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int rows, int cols, int disp_range)
+{
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        compute_sad_cost_row(left_pixels, left_stride, right_pixels, right_stride, cost_volume, y, cols, disp_range);
+    }
+}
+
+/**
+ * @brief One step of the SGM recursion for a single pixel, shared by every direction (horizontal, vertical,
+ * diagonal, both two-pass sweeps): out(d) = C(d) + min transition - min_k prev(k).
+ *
+ * The predecessor vector is copied into a padded line whose ends and inactive disparities hold 2000 - P1,
+ * so the +/- 1 neighbours evaluate to the 2000.0f boundary value without per-disparity branches and the
+ * disparity loop maps onto SIMD lanes (host) or parallel comparators (HLS). Entries d >= disp_range of
+ * @p out are unspecified.
+ * @param has_prev  False at the path start (out = C; @p prev is not read).
+ * @param prev      Path cost of the predecessor pixel.
+ */
+static void path_cost_step(
+    bool has_prev, const float prev[MAX_DISP], const float cost[MAX_DISP], float out[MAX_DISP],
+    int disp_range, int p1, int p2)
+{
+#pragma HLS INLINE
+    if (!has_prev)
+    {
+        // Boundary condition: Initialize path cost with raw matching cost
+        for (int d = 0; d < MAX_DISP; d++)
+            out[d] = cost[d];
+        return;
+    }
+
+    float padded[MAX_DISP + 2];
+#pragma HLS ARRAY_PARTITION variable = padded complete
+    float sentinel = 2000.0f - p1;
+    padded[0] = sentinel;
+    padded[MAX_DISP + 1] = sentinel;
+
+    // Find the minimum aggregated cost at the previous pixel across all disparities for normalization
+    float min_prev_aggregated = prev[0];
+    for (int i = 0; i < MAX_DISP; i++)
+    {
+        float active = (i < disp_range) ? prev[i] : prev[0];
+        min_prev_aggregated = (active < min_prev_aggregated) ? active : min_prev_aggregated;
+        padded[i + 1] = (i < disp_range) ? prev[i] : sentinel;
+    }
+
+    for (int d = 0; d < MAX_DISP; d++)
+    {
+        // Case 0: No change in disparity
+        float cost_same = padded[d + 1];
+
+        // Case 1 & 2: Small disparity change (+/- 1) penalized by P1
+        float cost_step_down = padded[d] + p1;
+        float cost_step_up = padded[d + 2] + p1;
+
+        // Case 3: Large disparity change (>1) penalized by P2
+        float cost_jump = min_prev_aggregated + p2;
+
+        // Select the minimum cost among all possible transitions
+        float min_transition_cost = cost_same;
+        min_transition_cost = (cost_step_down < min_transition_cost) ? cost_step_down : min_transition_cost;
+        min_transition_cost = (cost_step_up < min_transition_cost) ? cost_step_up : min_transition_cost;
+        min_transition_cost = (cost_jump < min_transition_cost) ? cost_jump : min_transition_cost;
+
+        // Update path cost: L_r(p, d) = C(p, d) + min_transition - min_prev_normalization
+        out[d] = cost[d] + (min_transition_cost - min_prev_aggregated);
+    }
+}
+
+/**
+ * @brief Aggregates one row of a path direction. Rows must be visited in the scan order of dir_y.
+ */
+template <typename pixel_t>
+static void aggregate_path_row(
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    bool recompute,
+    float path_cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int dir_y, int dir_x, int y,
+    int rows, int cols, int disp_range,
+    int p1, int p2)
+{
+    int x_start = (dir_x >= 0) ? 0 : cols - 1;
+    int x_end = (dir_x >= 0) ? cols : -1;
+    int x_step = (dir_x >= 0) ? 1 : -1;
+
+    for (int x = x_start; x != x_end; x += x_step)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+        int prev_y = y - dir_y;
+        int prev_x = x - dir_x;
+        float cost[MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = cost complete
+        load_pixel_cost(cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute, y, x,
+                        disp_range, cost);
+
+        // Check if the previous pixel in the path is within the frame boundaries (else its index is unused)
+        bool has_prev = prev_y >= 0 && prev_y < rows && prev_x >= 0 && prev_x < cols;
+        path_cost_step(has_prev, path_cost_volume[has_prev ? prev_y : y][has_prev ? prev_x : x], cost,
+                       path_cost_volume[y][x], disp_range, p1, p2);
+    }
+}
+
 /**
  * @brief Aggregates cost along a 1D path according to the SGM energy minimization recursive formula.
  * * L_r(p, d) = C(p, d) + min [ L_r(p-r, d), L_r(p-r, d-1)+P1, L_r(p-r, d+1)+P1, min_k(L_r(p-r, k))+P2 ] - min_k(L_r(p-r, k))
  * * @param cost_volume     Input matching cost volume C(p, d).
+ * @param left_pixels, right_pixels  Images the cost is recomputed from when @p recompute is set, read in place
+ *                          as pixel_t (layout as in compute_sad_cost_row).
+ * @param left_stride, right_stride  Pixels between image rows.
+ * @param recompute         Recompute C(p, d) on the fly instead of reading cost_volume.
  * @param path_cost_volume  Output aggregated cost volume L_r(p, d) for the current direction.
  * @param dir_y             Vertical direction component (dy).
  * @param dir_x             Horizontal direction component (dx).
+ * @param rows, cols, disp_range  Active geometry (within HEIGHT x WIDTH x MAX_DISP).
+ * @param p1, p2            Smoothness penalties.
  */
+template <typename pixel_t>
 void aggregate_path_hls(
     float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    bool recompute,
     float path_cost_volume[HEIGHT][WIDTH][MAX_DISP],
-    int dir_y, int dir_x)
+    int dir_y, int dir_x,
+    int rows, int cols, int disp_range,
+    int p1, int p2)
 {
     // Determine iteration scan order based on the aggregation direction vector
-    int y_start = (dir_y >= 0) ? 0 : HEIGHT - 1;
-    int y_end = (dir_y >= 0) ? HEIGHT : -1;
+    int y_start = (dir_y >= 0) ? 0 : rows - 1;
+    int y_end = (dir_y >= 0) ? rows : -1;
     int y_step = (dir_y >= 0) ? 1 : -1;
 
-    int x_start = (dir_x >= 0) ? 0 : WIDTH - 1;
-    int x_end = (dir_x >= 0) ? WIDTH : -1;
-    int x_step = (dir_x >= 0) ? 1 : -1;
-
     for (int y = y_start; y != y_end; y += y_step)
     {
-        for (int x = x_start; x != x_end; x += x_step)
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        aggregate_path_row(cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute,
+                           path_cost_volume, dir_y, dir_x, y, rows, cols, disp_range, p1, p2);
+    }
+}
+
+/**
+ * @brief More-Global-Matching (MGM) quadrant sweep: each step averages the SGM recursion from the horizontal
+ * and the vertical predecessor, so the path state propagates over the whole quadrant instead of one line.
+ * * L(p, d) = 1/2 * sum over q in {p - (0, sweep_x), p - (sweep_y, 0)} of [ C(p, d) + min transition(q) - min_k L(q, k) ]
+ * Both terms come from path_cost_step(), so the disparity loop vectorizes like the 1D paths. Pixels on the
+ * first row / column of the sweep have one predecessor (plain SGM step), the corner pixel none (L = C).
+ * @param sweep_y, sweep_x  Scan direction (+1 / -1 each): rows top-down or bottom-up, columns likewise.
+ */
+template <typename pixel_t>
+void aggregate_mgm_hls(
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    bool recompute,
+    float path_cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    int sweep_y, int sweep_x,
+    int rows, int cols, int disp_range,
+    int p1, int p2)
+{
+    int y_start = (sweep_y >= 0) ? 0 : rows - 1;
+    int y_end = (sweep_y >= 0) ? rows : -1;
+    int x_start = (sweep_x >= 0) ? 0 : cols - 1;
+    int x_end = (sweep_x >= 0) ? cols : -1;
+
+    for (int y = y_start; y != y_end; y += sweep_y)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        for (int x = x_start; x != x_end; x += sweep_x)
+        {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+            float cost[MAX_DISP];
+            float from_side[MAX_DISP];
+            float from_line[MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = cost complete
+#pragma HLS ARRAY_PARTITION variable = from_side complete
+#pragma HLS ARRAY_PARTITION variable = from_line complete
+            load_pixel_cost(cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute, y, x,
+                            disp_range, cost);
+
+            // A missing predecessor is replaced by the other one, which makes the average a plain SGM step;
+            // the corner pixel has neither and its (unread) index stays at the pixel itself
+            bool has_side = x != x_start;
+            bool has_line = y != y_start;
+            int side_y = (has_side || !has_line) ? y : y - sweep_y;
+            int side_x = has_side ? x - sweep_x : x;
+            int line_y = has_line ? y - sweep_y : y;
+            int line_x = (has_line || !has_side) ? x : x - sweep_x;
+            bool has_prev = has_side || has_line;
+            path_cost_step(has_prev, path_cost_volume[side_y][side_x], cost, from_side, disp_range, p1, p2);
+            path_cost_step(has_prev, path_cost_volume[line_y][line_x], cost, from_line, disp_range, p1, p2);
+
+            for (int d = 0; d < MAX_DISP; d++)
+                path_cost_volume[y][x][d] = 0.5f * (from_side[d] + from_line[d]);
+        }
+    }
+}
+
+/**
+ * @brief Sums the active path volumes of one row and selects the minimum-energy disparities (WTA).
+ */
+static void select_disparity_wta_row(
+    float (*const path_cost[SGM_MAX_PATHS])[WIDTH][MAX_DISP],
+    int disparity_output[HEIGHT * WIDTH],
+    int y, int cols, int disp_range, int num_paths)
+{
+    for (int x = 0; x < cols; x++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+        // Combine costs from all active aggregation paths
+        float total_aggregated_cost[MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = total_aggregated_cost complete
+        for (int d = 0; d < MAX_DISP; d++)
+            total_aggregated_cost[d] = path_cost[0][y][x][d];
+        for (int r = 1; r < SGM_MAX_PATHS; r++)
+        {
+            if (r >= num_paths)
+                break;
+            for (int d = 0; d < MAX_DISP; d++)
+                total_aggregated_cost[d] += path_cost[r][y][x][d];
+        }
+
+        float min_total_cost = 1e9;
+        int best_disparity = 0;
+
+        for (int d = 0; d < MAX_DISP; d++)
+        {
+            // Select disparity with the lowest total energy (WTA)
+            if (d < disp_range && total_aggregated_cost[d] < min_total_cost)
+            {
+                min_total_cost = total_aggregated_cost[d];
+                best_disparity = d;
+            }
+        }
+        disparity_output[y * cols + x] = best_disparity;
+    }
+}
+
+/**
+ * @brief Sums the active path volumes and selects the disparity with minimum energy (Winner-Take-All).
+ */
+void select_disparity_wta_hls(
+    float (*const path_cost[SGM_MAX_PATHS])[WIDTH][MAX_DISP],
+    int disparity_output[HEIGHT * WIDTH],
+    int rows, int cols, int disp_range, int num_paths)
+{
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        select_disparity_wta_row(path_cost, disparity_output, y, cols, disp_range, num_paths);
+    }
+}
+
+/**
+ * @brief Forward (raster-order) update of one pixel: L->R from the pixel state plus up to three row-to-row
+ * directions (T->B, TL->BR, TR->BL) from the previous line, summed in that order into forward_sum.
+ * @param line_paths  Active row-to-row directions: 0 (L->R only), 1 (+ T->B) or SGM_LINE_PATHS (+ diagonals).
+ */
+static void forward_pixel_update(
+    const float cost[MAX_DISP], float pixel_prev[MAX_DISP],
+    float line_buffer[2][SGM_LINE_PATHS][WIDTH][MAX_DISP], int prev_line, int cur_line,
+    int y, int x, int cols, int disp_range, int p1, int p2, int line_paths,
+    float forward_sum[MAX_DISP])
+{
+#pragma HLS INLINE
+    float pixel_cur[MAX_DISP];
+    float line_cur[SGM_LINE_PATHS][MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = pixel_cur complete
+#pragma HLS ARRAY_PARTITION variable = line_cur complete dim = 0
+
+    // Diagonal predecessors outside the frame keep the index x (not read)
+    path_cost_step(x > 0, pixel_prev, cost, pixel_cur, disp_range, p1, p2);
+    if (line_paths > 0)
+        path_cost_step(y > 0, line_buffer[prev_line][0][x], cost, line_cur[0], disp_range, p1, p2);
+    if (line_paths > 1)
+    {
+        path_cost_step(y > 0 && x > 0, line_buffer[prev_line][1][(x > 0) ? x - 1 : x], cost, line_cur[1],
+                       disp_range, p1, p2);
+        path_cost_step(y > 0 && x < cols - 1, line_buffer[prev_line][2][(x < cols - 1) ? x + 1 : x], cost,
+                       line_cur[2], disp_range, p1, p2);
+    }
+
+    for (int d = 0; d < MAX_DISP; d++)
+    {
+        forward_sum[d] = pixel_cur[d];
+        pixel_prev[d] = pixel_cur[d];
+    }
+    for (int r = 0; r < SGM_LINE_PATHS; r++)
+    {
+        if (r >= line_paths)
+            break;
+        for (int d = 0; d < MAX_DISP; d++)
+        {
+            forward_sum[d] += line_cur[r][d];
+            line_buffer[cur_line][r][x][d] = line_cur[r][d];
+        }
+    }
+}
+
+/**
+ * @brief Backward (reverse raster) update of one pixel: R->L from the pixel state plus B->T, BR->TL and
+ * BL->TR from the previous (lower) line, summed in that order into backward_sum.
+ */
+static void backward_pixel_update(
+    const float cost[MAX_DISP], float pixel_prev[MAX_DISP],
+    float line_buffer[2][SGM_LINE_PATHS][WIDTH][MAX_DISP], int prev_line, int cur_line,
+    int y, int x, int rows, int cols, int disp_range, int p1, int p2,
+    float backward_sum[MAX_DISP])
+{
+#pragma HLS INLINE
+    float pixel_cur[MAX_DISP];
+    float line_cur[SGM_LINE_PATHS][MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = pixel_cur complete
+#pragma HLS ARRAY_PARTITION variable = line_cur complete dim = 0
+
+    bool below = y < rows - 1;
+    path_cost_step(x < cols - 1, pixel_prev, cost, pixel_cur, disp_range, p1, p2);
+    path_cost_step(below, line_buffer[prev_line][0][x], cost, line_cur[0], disp_range, p1, p2);
+    path_cost_step(below && x < cols - 1, line_buffer[prev_line][1][(x < cols - 1) ? x + 1 : x], cost,
+                   line_cur[1], disp_range, p1, p2);
+    path_cost_step(below && x > 0, line_buffer[prev_line][2][(x > 0) ? x - 1 : x], cost, line_cur[2],
+                   disp_range, p1, p2);
+
+    for (int d = 0; d < MAX_DISP; d++)
+    {
+        backward_sum[d] = pixel_cur[d];
+        pixel_prev[d] = pixel_cur[d];
+    }
+    for (int r = 0; r < SGM_LINE_PATHS; r++)
+    {
+        for (int d = 0; d < MAX_DISP; d++)
+        {
+            backward_sum[d] += line_cur[r][d];
+            line_buffer[cur_line][r][x][d] = line_cur[r][d];
+        }
+    }
+}
+
+/**
+ * @brief Single raster sweep over the forward directions with WTA fused (the sgm_top_4path_v scheme).
+ *
+ * Each cost vector is loaded once and updates every active direction: L->R (1 path), + T->B (2 paths),
+ * + TL->BR and TR->BL (4 paths). No path volume is stored; 1 and 2 paths give the same result as the
+ * stored-volume modes, 4 paths use the two downward diagonals instead of R->L and B->T.
+ */
+template <typename pixel_t>
+void aggregate_single_sweep_hls(
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    bool recompute,
+    float line_buffer[2][SGM_LINE_PATHS][WIDTH][MAX_DISP],
+    int disparity_output[HEIGHT * WIDTH],
+    int rows, int cols, int disp_range, int num_paths,
+    int p1, int p2)
+{
+    int line_paths = (num_paths >= 4) ? SGM_LINE_PATHS : num_paths - 1;
+    float pixel_prev[MAX_DISP];
+    float forward_sum[MAX_DISP];
+    float cost[MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = pixel_prev complete
+#pragma HLS ARRAY_PARTITION variable = forward_sum complete
+#pragma HLS ARRAY_PARTITION variable = cost complete
+
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        int prev_line = (y + 1) & 1;
+        int cur_line = y & 1;
+        for (int x = 0; x < cols; x++)
         {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
 #pragma HLS PIPELINE II = 1
-            int prev_y = y - dir_y;
-            int prev_x = x - dir_x;
+            load_pixel_cost(cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute, y, x,
+                            disp_range, cost);
+            forward_pixel_update(cost, pixel_prev, line_buffer, prev_line, cur_line, y, x, cols, disp_range,
+                                 p1, p2, line_paths, forward_sum);
 
-            // Check if the previous pixel in the path is within the frame boundaries
-            if (prev_y >= 0 && prev_y < HEIGHT && prev_x >= 0 && prev_x < WIDTH)
+            float min_total_cost = 1e9;
+            int best_disparity = 0;
+            for (int d = 0; d < MAX_DISP; d++)
             {
-                // Find the minimum aggregated cost at the previous pixel across all disparities for normalization
-                float min_prev_aggregated = path_cost_volume[prev_y][prev_x][0];
-                for (int i = 1; i < MAX_DISP; i++)
+                if (d < disp_range && forward_sum[d] < min_total_cost)
                 {
-                    if (path_cost_volume[prev_y][prev_x][i] < min_prev_aggregated)
-                        min_prev_aggregated = path_cost_volume[prev_y][prev_x][i];
+                    min_total_cost = forward_sum[d];
+                    best_disparity = d;
                 }
+            }
+            disparity_output[y * cols + x] = best_disparity;
+        }
+    }
+}
+
+/**
+ * @brief Two-sweep 8-path aggregation with WTA fused into the second sweep.
+ *
+ * The forward sweep (raster order) runs L->R, T->B, TL->BR and TR->BL and stores only their sum. The
+ * backward sweep (reverse raster order) runs the four reverse directions, adds the stored sum and selects
+ * the disparity. Horizontal paths keep one pixel of state, the others a previous / current line pair.
+ * Diagonal predecessors are read from the previous line at x - 1 / x + 1, i.e. the line buffer is the
+ * sheared view of the diagonal: neighbours along the path sit one MAX_DISP vector apart, never W + 1.
+ * With compress_step > 0 the forward sum is stored as its per-pixel minimum plus one byte per disparity,
+ * (sum - min) / compress_step rounded and saturated at SGM_DELTA_MAX, a quarter of the float volume.
+ * Candidates beyond the cap are far from winning; integer costs with step 1 decode exactly below it.
+ * @param recompute    Recompute C(p, d) from the images in both sweeps instead of reading cost_volume.
+ * @param summed_cost  Scratch volume for the forward sum (float storage).
+ * @param summed_min, summed_delta  Scratch storage for the compressed forward sum.
+ * @param line_buffer  Ping-pong rows of the three row-to-row paths of the active sweep.
+ */
+template <typename pixel_t>
+void aggregate_two_pass_hls(
+    float cost_volume[HEIGHT][WIDTH][MAX_DISP],
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    bool recompute,
+    float summed_cost[HEIGHT][WIDTH][MAX_DISP],
+    float summed_min[HEIGHT][WIDTH],
+    unsigned char summed_delta[HEIGHT][WIDTH][MAX_DISP],
+    float line_buffer[2][SGM_LINE_PATHS][WIDTH][MAX_DISP],
+    int disparity_output[HEIGHT * WIDTH],
+    int rows, int cols, int disp_range,
+    int p1, int p2, int compress_step)
+{
+    float pixel_prev[MAX_DISP];
+    float forward_sum[MAX_DISP];
+    float backward_sum[MAX_DISP];
+    float cost[MAX_DISP];
+#pragma HLS ARRAY_PARTITION variable = pixel_prev complete
+#pragma HLS ARRAY_PARTITION variable = cost complete
+#pragma HLS ARRAY_PARTITION variable = forward_sum complete
+#pragma HLS ARRAY_PARTITION variable = backward_sum complete
+
+    // Pass 1 (forward): predecessors lie left, above, above-left and above-right
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        int prev_line = (y + 1) & 1;
+        int cur_line = y & 1;
+        for (int x = 0; x < cols; x++)
+        {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+            load_pixel_cost(cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute, y, x,
+                            disp_range, cost);
+            forward_pixel_update(cost, pixel_prev, line_buffer, prev_line, cur_line, y, x, cols, disp_range,
+                                 p1, p2, SGM_LINE_PATHS, forward_sum);
+
+            float forward_min = 1e9;
+            for (int d = 0; d < MAX_DISP; d++)
+            {
+                if (d < disp_range && forward_sum[d] < forward_min)
+                    forward_min = forward_sum[d];
+            }
 
+            if (compress_step > 0)
+            {
+                summed_min[y][x] = forward_min;
                 for (int d = 0; d < MAX_DISP; d++)
                 {
-                    // Case 0: No change in disparity
-                    float cost_same = path_cost_volume[prev_y][prev_x][d];
-
-                    // Case 1 & 2: Small disparity change (+/- 1) penalized by P1
-                    float cost_step_down = (d > 0) ? path_cost_volume[prev_y][prev_x][d - 1] + P1_PENALTY : 2000.0f;
-                    float cost_step_up = (d < MAX_DISP - 1) ? path_cost_volume[prev_y][prev_x][d + 1] + P1_PENALTY : 2000.0f;
-
-                    // Case 3: Large disparity change (>1) penalized by P2
-                    float cost_jump = min_prev_aggregated + P2_PENALTY;
-
-                    // Select the minimum cost among all possible transitions
-                    float min_transition_cost = cost_same;
-                    if (cost_step_down < min_transition_cost)
-                        min_transition_cost = cost_step_down;
-                    if (cost_step_up < min_transition_cost)
-                        min_transition_cost = cost_step_up;
-                    if (cost_jump < min_transition_cost)
-                        min_transition_cost = cost_jump;
-
-                    // Update path cost: L_r(p, d) = C(p, d) + min_transition - min_prev_normalization
-                    path_cost_volume[y][x][d] = cost_volume[y][x][d] + (min_transition_cost - min_prev_aggregated);
+                    // Entries d >= disp_range are unspecified and may lie below forward_min; the cast of a
+                    // negative step count would be undefined, so they are stored saturated
+                    float steps = (forward_sum[d] - forward_min) / compress_step + 0.5f;
+                    summed_delta[y][x][d] =
+                        (d < disp_range && steps < SGM_DELTA_MAX) ? (unsigned char)steps : SGM_DELTA_MAX;
                 }
             }
             else
             {
-                // Boundary condition: Initialize path cost with raw matching cost
                 for (int d = 0; d < MAX_DISP; d++)
-                    path_cost_volume[y][x][d] = cost_volume[y][x][d];
+                    summed_cost[y][x][d] = forward_sum[d];
+            }
+        }
+    }
+
+    // Pass 2 (backward): predecessors lie right, below, below-right and below-left
+    for (int y = rows - 1; y >= 0; y--)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        int prev_line = (y + 1) & 1;
+        int cur_line = y & 1;
+        for (int x = cols - 1; x >= 0; x--)
+        {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+            load_pixel_cost(cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute, y, x,
+                            disp_range, cost);
+            backward_pixel_update(cost, pixel_prev, line_buffer, prev_line, cur_line, y, x, rows, cols, disp_range,
+                                  p1, p2, backward_sum);
+
+            float min_total_cost = 1e9;
+            int best_disparity = 0;
+            for (int d = 0; d < MAX_DISP; d++)
+            {
+                float forward = (compress_step > 0) ? summed_min[y][x] + summed_delta[y][x][d] * (float)compress_step
+                                                    : summed_cost[y][x][d];
+                float total = forward + backward_sum[d];
+                if (d < disp_range && total < min_total_cost)
+                {
+                    min_total_cost = total;
+                    best_disparity = d;
+                }
             }
+            disparity_output[y * cols + x] = best_disparity;
         }
     }
 }
 
 /**
- * @brief Top-level HLS entry point for Semi-Global Matching (SGM).
- * Performs matching cost calculation, 4-path aggregation, and Winner-Take-All disparity selection.
+ * @brief Keeps the SGM_BOUNDED_CANDIDATES cheapest (disparity, value) pairs seen so far, sorted ascending.
+ * Called in increasing disparity order with a strict comparison, so ties keep the lower disparity.
  */
-void sgm_hls(
-    float left_pixels[HEIGHT * WIDTH],
-    float right_pixels[HEIGHT * WIDTH],
-    int disparity_output[HEIGHT * WIDTH])
+static void insert_candidate(
+    int d, float value, short disparity[SGM_BOUNDED_CANDIDATES], float cost[SGM_BOUNDED_CANDIDATES])
 {
-// AXI4-Master interfaces for high-bandwidth off-chip memory access
-#pragma HLS INTERFACE m_axi port = left_pixels offset = slave bundle = gmem
-#pragma HLS INTERFACE m_axi port = right_pixels offset = slave bundle = gmem
-#pragma HLS INTERFACE m_axi port = disparity_output offset = slave bundle = gmem
+#pragma HLS INLINE
+    for (int k = SGM_BOUNDED_CANDIDATES - 1; k >= 0; k--)
+    {
+        if (value >= cost[k])
+            break;
+        if (k + 1 < SGM_BOUNDED_CANDIDATES)
+        {
+            cost[k + 1] = cost[k];
+            disparity[k + 1] = disparity[k];
+        }
+        cost[k] = value;
+        disparity[k] = (short)d;
+    }
+}
+
+/**
+ * @brief Memory-bounded 8-path aggregation (eSGM): three sweeps keep a few candidates per pixel instead of
+ * a summed volume, so the working set is the line buffers (W x D) plus per-pixel candidates (H x W).
+ *
+ * Pass 1 (forward) stores the SGM_BOUNDED_CANDIDATES disparities with the lowest forward sum and those
+ * partial sums. Pass 2 (backward) completes them with the backward sum and stores the best backward
+ * candidates among the remaining disparities. Pass 3 repeats the forward sweep to complete those and
+ * selects the cheapest complete sum. Costs are recomputed from the images in every pass. The result equals
+ * the two-pass mode wherever the full minimum is among the candidates.
+ * @param candidate_disparity  Slots [0, K): forward candidates, [K, 2K): backward candidates.
+ * @param candidate_cost       Matching path sums (forward or backward part until completed).
+ */
+template <typename pixel_t>
+void aggregate_memory_bounded_hls(
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    short candidate_disparity[HEIGHT][WIDTH][2 * SGM_BOUNDED_CANDIDATES],
+    float candidate_cost[HEIGHT][WIDTH][2 * SGM_BOUNDED_CANDIDATES],
+    float line_buffer[2][SGM_LINE_PATHS][WIDTH][MAX_DISP],
+    int disparity_output[HEIGHT * WIDTH],
+    int rows, int cols, int disp_range,
+    int p1, int p2)
+{
+    float pixel_prev[MAX_DISP];
+    float path_sum[MAX_DISP];
+    float cost[MAX_DISP];
+    short best_disparity[SGM_BOUNDED_CANDIDATES];
+    float best_cost[SGM_BOUNDED_CANDIDATES];
+#pragma HLS ARRAY_PARTITION variable = pixel_prev complete
+#pragma HLS ARRAY_PARTITION variable = path_sum complete
+#pragma HLS ARRAY_PARTITION variable = cost complete
+#pragma HLS ARRAY_PARTITION variable = best_disparity complete
+#pragma HLS ARRAY_PARTITION variable = best_cost complete
+
+    // Pass 1 (forward): best forward candidates per pixel
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        for (int x = 0; x < cols; x++)
+        {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+            recompute_pixel_cost(left_pixels, left_stride, right_pixels, right_stride, y, x, disp_range, cost);
+            forward_pixel_update(cost, pixel_prev, line_buffer, (y + 1) & 1, y & 1, y, x, cols, disp_range,
+                                 p1, p2, SGM_LINE_PATHS, path_sum);
+
+            for (int k = 0; k < SGM_BOUNDED_CANDIDATES; k++)
+            {
+                best_disparity[k] = 0;
+                best_cost[k] = 1e9;
+            }
+            for (int d = 0; d < MAX_DISP; d++)
+            {
+                if (d < disp_range)
+                    insert_candidate(d, path_sum[d], best_disparity, best_cost);
+            }
+            for (int k = 0; k < SGM_BOUNDED_CANDIDATES; k++)
+            {
+                candidate_disparity[y][x][k] = best_disparity[k];
+                candidate_cost[y][x][k] = best_cost[k];
+            }
+        }
+    }
+
+    // Pass 2 (backward): complete the forward candidates, pick the best other disparities
+    for (int y = rows - 1; y >= 0; y--)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        for (int x = cols - 1; x >= 0; x--)
+        {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+            recompute_pixel_cost(left_pixels, left_stride, right_pixels, right_stride, y, x, disp_range, cost);
+            backward_pixel_update(cost, pixel_prev, line_buffer, (y + 1) & 1, y & 1, y, x, rows, cols, disp_range,
+                                  p1, p2, path_sum);
+
+            for (int k = 0; k < SGM_BOUNDED_CANDIDATES; k++)
+            {
+                best_disparity[k] = 0;
+                best_cost[k] = 1e9;
+            }
+            for (int d = 0; d < MAX_DISP; d++)
+            {
+                bool forward_candidate = false;
+                for (int k = 0; k < SGM_BOUNDED_CANDIDATES; k++)
+                    forward_candidate = forward_candidate || candidate_disparity[y][x][k] == d;
+                if (d < disp_range && !forward_candidate)
+                    insert_candidate(d, path_sum[d], best_disparity, best_cost);
+            }
+            for (int k = 0; k < SGM_BOUNDED_CANDIDATES; k++)
+            {
+                candidate_cost[y][x][k] += path_sum[candidate_disparity[y][x][k]];
+                candidate_disparity[y][x][SGM_BOUNDED_CANDIDATES + k] = best_disparity[k];
+                candidate_cost[y][x][SGM_BOUNDED_CANDIDATES + k] = best_cost[k];
+            }
+        }
+    }
+
+    // Pass 3 (forward again): complete the backward candidates and select
+    for (int y = 0; y < rows; y++)
+    {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT
+        for (int x = 0; x < cols; x++)
+        {
+#pragma HLS LOOP_TRIPCOUNT max = WIDTH
+#pragma HLS PIPELINE II = 1
+            recompute_pixel_cost(left_pixels, left_stride, right_pixels, right_stride, y, x, disp_range, cost);
+            forward_pixel_update(cost, pixel_prev, line_buffer, (y + 1) & 1, y & 1, y, x, cols, disp_range,
+                                 p1, p2, SGM_LINE_PATHS, path_sum);
+
+            int selected = candidate_disparity[y][x][0];
+            float min_total_cost = candidate_cost[y][x][0];
+            for (int k = 1; k < 2 * SGM_BOUNDED_CANDIDATES; k++)
+            {
+                int d = candidate_disparity[y][x][k];
+                float total = candidate_cost[y][x][k];
+                if (k >= SGM_BOUNDED_CANDIDATES)
+                    total += path_sum[d];
+                // Ties go to the lower disparity, as in the exhaustive WTA
+                if (total < min_total_cost || (total == min_total_cost && d < selected))
+                {
+                    min_total_cost = total;
+                    selected = d;
+                }
+            }
+            disparity_output[y * cols + x] = selected;
+        }
+    }
+}
+
+/**
+ * @brief Box-filters an image by an integer factor (subsampled processing) into a packed float frame.
+ * @param stride  Pixels between source rows (cols when packed).
+ */
+template <typename pixel_t>
+static void downsample_image(
+    const pixel_t *source, int stride, float target[HEIGHT * WIDTH],
+    int rows, int cols, int factor)
+{
+    int target_rows = rows / factor;
+    int target_cols = cols / factor;
+    float norm = 1.0f / (float)(factor * factor);
+
+    for (int y = 0; y < target_rows; y++)
+    {
+        for (int x = 0; x < target_cols; x++)
+        {
+            float sum = 0.0f;
+            for (int dy = 0; dy < factor; dy++)
+                for (int dx = 0; dx < factor; dx++)
+                    sum += (float)source[(y * factor + dy) * stride + (x * factor + dx)];
+            target[y * target_cols + x] = sum * norm;
+        }
+    }
+}
+
+/**
+ * @brief Nearest-neighbor upsampling of a subsampled disparity map, rescaling disparities to full resolution.
+ */
+static void upsample_disparity(
+    const int source[HEIGHT * WIDTH], int target[HEIGHT * WIDTH],
+    int rows, int cols, int factor)
+{
+    int source_rows = rows / factor;
+    int source_cols = cols / factor;
+
+    for (int y = 0; y < rows; y++)
+    {
+        int sy = (y / factor < source_rows) ? y / factor : source_rows - 1;
+        for (int x = 0; x < cols; x++)
+        {
+            int sx = (x / factor < source_cols) ? x / factor : source_cols - 1;
+            target[y * cols + x] = source[sy * source_cols + sx] * factor;
+        }
+    }
+}
+
+/**
+ * @brief True for the modes whose aggregation kernel selects the disparity itself (into disparity_scaled).
+ */
+static bool fused_selection(const sgm_config_t &config)
+{
+    return config.num_paths == SGM_TWO_PASS_PATHS || config.single_sweep != 0;
+}
+
+/**
+ * @brief True when aggregation derives C(p, d) from the images (recompute_cost, or implied by memory_bounded).
+ */
+static bool recompute_mode(const sgm_config_t &config)
+{
+    return config.recompute_cost != 0 || config.memory_bounded != 0;
+}
+
+/**
+ * @brief Processing geometry after subsampling (search range shrinks with the image).
+ */
+static void scaled_geometry(const sgm_config_t &config, int &rows, int &cols, int &disp_range)
+{
+    int factor = config.subsample;
+    rows = config.rows / factor;
+    cols = config.cols / factor;
+    disp_range = (config.disp_range + factor - 1) / factor;
+}
+
+/**
+ * @brief Matching cost volume (AD or MI lookup) of images read in place at the processing geometry.
+ */
+template <typename pixel_t>
+static void cost_volume_kernel(
+    const sgm_config_t &config,
+    const pixel_t *left, int left_stride,
+    const pixel_t *right, int right_stride,
+    int rows, int cols, int disp_range,
+    sgm_workspace_t &workspace)
+{
+    if (config.cost == SGM_COST_MI)
+    {
+        SGM_PROFILE_KERNEL("cost_mi", SGM_COST_BYTES(rows, cols, disp_range, sizeof(pixel_t)),
+                           SGM_MI_COST_OPS_PER_CELL * SGM_VOLUME_CELLS(rows, cols, disp_range));
+        compute_mi_cost_hls(left, left_stride, right, right_stride, workspace.mi_table, workspace.cost_volume,
+                            rows, cols, disp_range);
+        return;
+    }
+    SGM_PROFILE_KERNEL("cost_sad", SGM_COST_BYTES(rows, cols, disp_range, sizeof(pixel_t)),
+                       SGM_COST_OPS_PER_CELL * SGM_VOLUME_CELLS(rows, cols, disp_range));
+    compute_sad_cost_hls(left, left_stride, right, right_stride, workspace.cost_volume, rows, cols, disp_range);
+}
+
+/* --- SGM_PIXEL_* code of a pixel type, recorded with the images the recompute modes read in place --- */
+static int pixel_type_of(const unsigned char *) { return SGM_PIXEL_U8; }
+static int pixel_type_of(const unsigned short *) { return SGM_PIXEL_U16; }
+static int pixel_type_of(const float *) { return SGM_PIXEL_F32; }
+
+/**
+ * @brief Records the images that sgm_stage_aggregate reads in place (recompute modes); stride in pixels.
+ */
+template <typename pixel_t>
+static void keep_images(
+    const pixel_t *left, int left_stride, const pixel_t *right, int right_stride, sgm_workspace_t &workspace)
+{
+    workspace.left_view = sgm_make_view(left, pixel_type_of(left), left_stride * (int)sizeof(pixel_t));
+    workspace.right_view = sgm_make_view(right, pixel_type_of(right), right_stride * (int)sizeof(pixel_t));
+}
+
+/**
+ * @brief sgm_stage_cost on images of any pixel type with row strides in pixels (packed: config.cols).
+ */
+template <typename pixel_t>
+static void stage_cost(
+    const sgm_config_t &config,
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    sgm_workspace_t &workspace)
+{
+    int rows, cols, disp_range;
+    scaled_geometry(config, rows, cols, disp_range);
+
+    // 0. Optional subsampling: process a box-filtered frame with a proportionally reduced search range
+    if (config.subsample > 1)
+    {
+        {
+            SGM_PROFILE_STAGE("subsample");
+            downsample_image(left_pixels, left_stride, workspace.left_scaled, config.rows, config.cols,
+                             config.subsample);
+            downsample_image(right_pixels, right_stride, workspace.right_scaled, config.rows, config.cols,
+                             config.subsample);
+        }
+        if (recompute_mode(config))
+            keep_images((const float *)workspace.left_scaled, cols, (const float *)workspace.right_scaled, cols,
+                        workspace);
+        else
+            cost_volume_kernel(config, (const float *)workspace.left_scaled, cols,
+                               (const float *)workspace.right_scaled, cols, rows, cols, disp_range, workspace);
+        return;
+    }
+
+    // 1a. Recompute mode: aggregation derives C(p, d) from the caller's images, which stay in place
+    if (recompute_mode(config))
+    {
+        keep_images(left_pixels, left_stride, right_pixels, right_stride, workspace);
+        return;
+    }
+
+    // 1. Matching Cost Computation, reading the caller's images in place
+    cost_volume_kernel(config, left_pixels, left_stride, right_pixels, right_stride, rows, cols, disp_range,
+                       workspace);
+}
+
+void sgm_stage_cost(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    stage_cost(config, left_pixels, config.cols, right_pixels, config.cols, workspace);
+}
+
+/* --- Mutual information table (Parzen smoothing: 7-tap binomial kernel, zero outside the level range) --- */
+static const float mi_kernel[7] = {1.0f / 64, 6.0f / 64, 15.0f / 64, 20.0f / 64, 15.0f / 64, 6.0f / 64, 1.0f / 64};
+#define SGM_MI_KERNEL_RADIUS 3
+#define SGM_MI_MIN_PROBABILITY 1e-9f // Floor before the logarithm for unobserved intensity pairs
+
+/**
+ * @brief Convolves a histogram with mi_kernel.
+ */
+static void smooth_levels(const float source[SGM_MI_LEVELS], float target[SGM_MI_LEVELS])
+{
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+    {
+        float sum = 0.0f;
+        for (int t = -SGM_MI_KERNEL_RADIUS; t <= SGM_MI_KERNEL_RADIUS; t++)
+        {
+            if (i + t >= 0 && i + t < SGM_MI_LEVELS)
+                sum += mi_kernel[t + SGM_MI_KERNEL_RADIUS] * source[i + t];
+        }
+        target[i] = sum;
+    }
+}
+
+/**
+ * @brief Separable 2D convolution of a joint table with mi_kernel, in place (scratch holds the row pass).
+ */
+static void smooth_table(float table[SGM_MI_LEVELS][SGM_MI_LEVELS], float scratch[SGM_MI_LEVELS][SGM_MI_LEVELS])
+{
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+        smooth_levels(table[i], scratch[i]);
+
+    float column[SGM_MI_LEVELS];
+    float smoothed[SGM_MI_LEVELS];
+    for (int k = 0; k < SGM_MI_LEVELS; k++)
+    {
+        for (int i = 0; i < SGM_MI_LEVELS; i++)
+            column[i] = scratch[i][k];
+        smooth_levels(column, smoothed);
+        for (int i = 0; i < SGM_MI_LEVELS; i++)
+            table[i][k] = smoothed[i];
+    }
+}
+
+/**
+ * @brief Entropy term h = -log(P (*) g) (*) g of a smoothed histogram, in place.
+ */
+static void entropy_levels(float levels[SGM_MI_LEVELS])
+{
+    float smoothed[SGM_MI_LEVELS];
+    smooth_levels(levels, smoothed);
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+        smoothed[i] = -hls::log((smoothed[i] > SGM_MI_MIN_PROBABILITY) ? smoothed[i] : SGM_MI_MIN_PROBABILITY);
+    smooth_levels(smoothed, levels);
+}
+
+/**
+ * @brief sgm_stage_mi_table on images of any pixel type with row strides in pixels.
+ */
+template <typename pixel_t>
+static void build_mi_table(
+    const sgm_config_t &config,
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    const int disparity[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    SGM_PROFILE_STAGE("mi_table");
+    float (*joint)[SGM_MI_LEVELS] = workspace.mi_table;
+    float left_levels[SGM_MI_LEVELS];
+    float right_levels[SGM_MI_LEVELS];
+
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+    {
+        left_levels[i] = 0.0f;
+        right_levels[i] = 0.0f;
+        for (int k = 0; k < SGM_MI_LEVELS; k++)
+            joint[i][k] = 0.0f;
+    }
+
+    // Joint histogram of corresponding intensities under the current disparity estimate
+    int samples = 0;
+    for (int y = 0; y < config.rows; y++)
+    {
+        for (int x = 0; x < config.cols; x++)
+        {
+            int d = disparity[y * config.cols + x];
+            if (x - d < 0)
+                continue;
+            int i = intensity_level((float)left_pixels[y * left_stride + x]);
+            int k = intensity_level((float)right_pixels[y * right_stride + (x - d)]);
+            joint[i][k] += 1.0f;
+            left_levels[i] += 1.0f;
+            right_levels[k] += 1.0f;
+            samples++;
+        }
+    }
+    float norm = 1.0f / (float)((samples > 0) ? samples : 1);
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+    {
+        left_levels[i] *= norm;
+        right_levels[i] *= norm;
+        for (int k = 0; k < SGM_MI_LEVELS; k++)
+            joint[i][k] *= norm;
+    }
+
+    // h12(i, k) = -log(P12 (*) g) (*) g, h1 / h2 likewise on the marginals
+    smooth_table(joint, workspace.mi_scratch);
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+    {
+        for (int k = 0; k < SGM_MI_LEVELS; k++)
+            joint[i][k] = -hls::log((joint[i][k] > SGM_MI_MIN_PROBABILITY) ? joint[i][k] : SGM_MI_MIN_PROBABILITY);
+    }
+    smooth_table(joint, workspace.mi_scratch);
+    entropy_levels(left_levels);
+    entropy_levels(right_levels);
+
+    // C(i, k) = -mi(i, k) = h12 - h1 - h2, shifted to a zero minimum and quantized to integer costs
+    float min_cost = 1e30f;
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+    {
+        for (int k = 0; k < SGM_MI_LEVELS; k++)
+        {
+            joint[i][k] -= left_levels[i] + right_levels[k];
+            min_cost = (joint[i][k] < min_cost) ? joint[i][k] : min_cost;
+        }
+    }
+    for (int i = 0; i < SGM_MI_LEVELS; i++)
+    {
+        for (int k = 0; k < SGM_MI_LEVELS; k++)
+        {
+            float cost = SGM_MI_SCALE * (joint[i][k] - min_cost);
+            joint[i][k] = (cost < SGM_MI_MAX_COST) ? (float)(int)(cost + 0.5f) : (float)SGM_MI_MAX_COST;
+        }
+    }
+}
+
+void sgm_stage_mi_table(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    const int disparity[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    build_mi_table(config, left_pixels, config.cols, right_pixels, config.cols, disparity, workspace);
+}
+
+int sgm_check_rgb_config(const sgm_config_t &config)
+{
+    if (sgm_check_config(config) != 0 || config.cost != SGM_COST_AD || config.subsample != 1 ||
+        recompute_mode(config))
+        return -1;
+    return 0;
+}
+
+void sgm_stage_cost_rgb(
+    const sgm_config_t &config,
+    const unsigned char left_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    const unsigned char right_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    sgm_workspace_t &workspace)
+{
+    // 1. Matching Cost Computation (color)
+    SGM_PROFILE_KERNEL("cost_rgb", SGM_RGB_COST_BYTES(config.rows, config.cols, config.disp_range),
+                       SGM_RGB_COST_OPS_PER_CELL * SGM_VOLUME_CELLS(config.rows, config.cols, config.disp_range));
+    compute_rgb_cost_hls(left_rgb, right_rgb, workspace.cost_volume, config.rows, config.cols, config.disp_range);
+}
+
+/**
+ * @brief sgm_stage_aggregate with the recompute modes reading images of any pixel type in place
+ * (row strides in pixels; unused when the cost volume is stored).
+ */
+template <typename pixel_t>
+static void stage_aggregate(
+    const sgm_config_t &config,
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    sgm_workspace_t &workspace)
+{
+#ifdef SGM_PROFILE
+    static const char *const aggregate_stage_names[SGM_MAX_PATHS] = {
+        "aggregate_left_to_right", "aggregate_top_to_bottom", "aggregate_right_to_left", "aggregate_bottom_to_top"};
+    static const char *const mgm_stage_names[SGM_MAX_PATHS] = {
+        "aggregate_mgm_tl_br", "aggregate_mgm_br_tl", "aggregate_mgm_tr_bl", "aggregate_mgm_bl_tr"};
+#endif
+    int rows, cols, disp_range;
+    scaled_geometry(config, rows, cols, disp_range);
+    bool recompute = recompute_mode(config);
+
+    // 2a. Eight paths, memory-bounded: three sweeps over per-pixel candidates, costs always recomputed
+    if (config.memory_bounded)
+    {
+        SGM_PROFILE_KERNEL("aggregate_memory_bounded_wta", SGM_MEMORY_BOUNDED_BYTES(rows, cols),
+                           (2 * SGM_FORWARD_OPS_PER_CELL + SGM_BACKWARD_OPS_PER_CELL + 3 * SGM_COST_OPS_PER_CELL) *
+                               SGM_VOLUME_CELLS(rows, cols, disp_range));
+        aggregate_memory_bounded_hls(left_pixels, left_stride, right_pixels, right_stride,
+                                     workspace.candidate_disparity, workspace.candidate_cost, workspace.line_buffer,
+                                     workspace.disparity_scaled, rows, cols, disp_range, config.p1, config.p2);
+        return;
+    }
+
+    // 2b. Eight paths: forward/backward sweeps over one summed volume, WTA fused into the backward sweep
+    if (config.num_paths == SGM_TWO_PASS_PATHS)
+    {
+        SGM_PROFILE_KERNEL("aggregate_two_pass_wta",
+                           SGM_FORWARD_BYTES(rows, cols, disp_range, config.compress_step, recompute) +
+                               SGM_BACKWARD_BYTES(rows, cols, disp_range, config.compress_step, recompute),
+                           (SGM_FORWARD_OPS_PER_CELL + SGM_BACKWARD_OPS_PER_CELL + 2 * SGM_COST_INPUT_OPS(recompute)) *
+                               SGM_VOLUME_CELLS(rows, cols, disp_range));
+        aggregate_two_pass_hls(workspace.cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute,
+                               workspace.summed_cost, workspace.summed_min,
+                               workspace.summed_delta, workspace.line_buffer, workspace.disparity_scaled,
+                               rows, cols, disp_range, config.p1, config.p2, config.compress_step);
+        return;
+    }
+
+    // 2c. Single sweep: every forward direction from one cost load per pixel, WTA fused
+    if (config.single_sweep)
+    {
+        SGM_PROFILE_KERNEL("aggregate_single_sweep_wta", SGM_SINGLE_SWEEP_BYTES(rows, cols, disp_range, recompute),
+                           (config.num_paths * SGM_AGGREGATE_OPS_PER_CELL + 1 + SGM_COST_INPUT_OPS(recompute)) *
+                               SGM_VOLUME_CELLS(rows, cols, disp_range));
+        aggregate_single_sweep_hls(workspace.cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute,
+                                   workspace.line_buffer, workspace.disparity_scaled, rows, cols, disp_range,
+                                   config.num_paths, config.p1, config.p2);
+        return;
+    }
+
+    // 2d. MGM: one quadrant sweep per stored path volume, summed by the regular WTA
+    if (config.mgm)
+    {
+        for (int r = 0; r < config.num_paths; r++)
+        {
+            SGM_PROFILE_KERNEL(mgm_stage_names[r], SGM_AGGREGATE_BYTES(rows, cols, disp_range, recompute),
+                               (SGM_MGM_OPS_PER_CELL + SGM_COST_INPUT_OPS(recompute)) *
+                                   SGM_VOLUME_CELLS(rows, cols, disp_range));
+            aggregate_mgm_hls(workspace.cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute,
+                              workspace.path_cost[r], mgm_sweep_y[r], mgm_sweep_x[r],
+                              rows, cols, disp_range, config.p1, config.p2);
+        }
+        return;
+    }
+
+    // 2. Multi-Path Cost Aggregation (Horizontal and Vertical directions)
+    for (int r = 0; r < config.num_paths; r++)
+    {
+        SGM_PROFILE_KERNEL(aggregate_stage_names[r], SGM_AGGREGATE_BYTES(rows, cols, disp_range, recompute),
+                           (SGM_AGGREGATE_OPS_PER_CELL + SGM_COST_INPUT_OPS(recompute)) *
+                               SGM_VOLUME_CELLS(rows, cols, disp_range));
+        aggregate_path_hls(workspace.cost_volume, left_pixels, left_stride, right_pixels, right_stride, recompute,
+                           workspace.path_cost[r], path_dir_y[r], path_dir_x[r],
+                           rows, cols, disp_range, config.p1, config.p2);
+    }
+}
+
+/* Calls function(config, left, left_stride, right, right_stride, ...) with the views' pixel type and strides
+ * converted to pixels. An unknown pixel type makes the calling function return -1. */
+#define SGM_VIEW_DISPATCH(function, left, right, ...)                                                                \
+    switch (left.pixel_type)                                                                                         \
+    {                                                                                                                \
+    case SGM_PIXEL_U8:                                                                                               \
+        function(config, (const unsigned char *)left.data, left.stride, (const unsigned char *)right.data,           \
+                 right.stride, __VA_ARGS__);                                                                         \
+        break;                                                                                                       \
+    case SGM_PIXEL_U16:                                                                                              \
+        function(config, (const unsigned short *)left.data, left.stride / 2, (const unsigned short *)right.data,     \
+                 right.stride / 2, __VA_ARGS__);                                                                     \
+        break;                                                                                                       \
+    case SGM_PIXEL_F32:                                                                                              \
+        function(config, (const float *)left.data, left.stride / 4, (const float *)right.data, right.stride / 4,     \
+                 __VA_ARGS__);                                                                                       \
+        break;                                                                                                       \
+    default:                                                                                                         \
+        return -1;                                                                                                   \
+    }
+
+/**
+ * @brief Aggregation over the images recorded by the cost stage (recompute modes).
+ */
+static int aggregate_kept_images(const sgm_config_t &config, sgm_workspace_t &workspace)
+{
+    SGM_VIEW_DISPATCH(stage_aggregate, workspace.left_view, workspace.right_view, workspace)
+    return 0;
+}
+
+void sgm_stage_aggregate(const sgm_config_t &config, sgm_workspace_t &workspace)
+{
+    if (recompute_mode(config))
+        aggregate_kept_images(config, workspace); // Views recorded by the cost stage always have a known type
+    else
+        stage_aggregate(config, (const float *)0, 0, (const float *)0, 0, workspace);
+}
+
+void sgm_stage_wta(const sgm_config_t &config, int disparity_output[HEIGHT * WIDTH], sgm_workspace_t &workspace)
+{
+    int rows, cols, disp_range;
+    scaled_geometry(config, rows, cols, disp_range);
+    int *disparity = (config.subsample > 1) ? workspace.disparity_scaled : disparity_output;
+
+    // 3. Final Summation and Winner-Take-All (WTA) Disparity Selection (8 paths / single sweep: already selected)
+    if (fused_selection(config))
+    {
+        if (config.subsample == 1)
+        {
+            for (int i = 0; i < rows * cols; i++)
+            {
+#pragma HLS LOOP_TRIPCOUNT max = HEIGHT * WIDTH
+#pragma HLS PIPELINE II = 1
+                disparity_output[i] = workspace.disparity_scaled[i];
+            }
+        }
+    }
+    else
+    {
+        SGM_PROFILE_KERNEL("wta", SGM_WTA_BYTES(rows, cols, disp_range, config.num_paths),
+                           SGM_WTA_OPS_PER_CELL * SGM_VOLUME_CELLS(rows, cols, disp_range));
+        select_disparity_wta_hls(workspace.path_cost, disparity, rows, cols, disp_range, config.num_paths);
+    }
+
+    if (config.subsample > 1)
+    {
+        SGM_PROFILE_STAGE("upsample");
+        upsample_disparity(workspace.disparity_scaled, disparity_output, config.rows, config.cols, config.subsample);
+    }
+}
+
+void sgm_compute(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    sgm_stage_cost(config, left_pixels, right_pixels, workspace);
+    sgm_stage_aggregate(config, workspace);
+    sgm_stage_wta(config, disparity_output, workspace);
+}
+
+void sgm_compute_rgb(
+    const sgm_config_t &config,
+    const unsigned char left_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    const unsigned char right_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    sgm_stage_cost_rgb(config, left_rgb, right_rgb, workspace);
+    sgm_stage_aggregate(config, workspace);
+    sgm_stage_wta(config, disparity_output, workspace);
+}
+
+/**
+ * @brief sgm_compute_hmi on images of any pixel type with row strides in pixels.
+ */
+template <typename pixel_t>
+static void compute_hmi(
+    const sgm_config_t &config,
+    const pixel_t *left_pixels, int left_stride,
+    const pixel_t *right_pixels, int right_stride,
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    sgm_config_t level = config;
+    int factor = config.subsample;
+    while (factor * 2 <= SGM_HMI_COARSE && config.rows / (factor * 2) >= 1 && config.cols / (factor * 2) >= 1)
+        factor *= 2;
+
+    // Bootstrap: AD at the coarsest level (upsampled to full resolution by sgm_stage_wta)
+    level.cost = SGM_COST_AD;
+    level.subsample = factor;
+    stage_cost(level, left_pixels, left_stride, right_pixels, right_stride, workspace);
+    sgm_stage_aggregate(level, workspace);
+    sgm_stage_wta(level, disparity_output, workspace);
+
+    // Refinement: MI table from the previous map, then match one level finer (at least once)
+    level.cost = SGM_COST_MI;
+    do
+    {
+        if (factor > config.subsample)
+            factor /= 2;
+        build_mi_table(config, left_pixels, left_stride, right_pixels, right_stride, disparity_output, workspace);
+        level.subsample = factor;
+        stage_cost(level, left_pixels, left_stride, right_pixels, right_stride, workspace);
+        sgm_stage_aggregate(level, workspace);
+        sgm_stage_wta(level, disparity_output, workspace);
+    } while (factor > config.subsample);
+}
+
+void sgm_compute_hmi(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    compute_hmi(config, left_pixels, config.cols, right_pixels, config.cols, disparity_output, workspace);
+}
+
+/**
+ * @brief Size of one SGM_PIXEL_* sample in bytes.
+ */
+static int pixel_bytes(int pixel_type)
+{
+    return (pixel_type == SGM_PIXEL_U8) ? 1 : (pixel_type == SGM_PIXEL_U16) ? 2 : 4;
+}
+
+sgm_image_view_t sgm_make_view(const void *data, int pixel_type, int stride)
+{
+    sgm_image_view_t view;
+    view.data = data;
+    view.pixel_type = pixel_type;
+    view.stride = stride;
+    return view;
+}
+
+sgm_image_view_t sgm_view_roi(const sgm_image_view_t &view, int x, int y)
+{
+    sgm_image_view_t roi = view;
+    roi.data = (const unsigned char *)view.data + (long)y * view.stride + (long)x * pixel_bytes(view.pixel_type);
+    return roi;
+}
+
+int sgm_check_view_config(const sgm_config_t &config, const sgm_image_view_t &left, const sgm_image_view_t &right)
+{
+    if (sgm_check_config(config) != 0 || !left.data || !right.data || left.pixel_type != right.pixel_type)
+        return -1;
+    if (left.pixel_type != SGM_PIXEL_U8 && left.pixel_type != SGM_PIXEL_U16 && left.pixel_type != SGM_PIXEL_F32)
+        return -1;
+    if (config.cost == SGM_COST_MI && left.pixel_type == SGM_PIXEL_U16)
+        return -1;
+
+    int size = pixel_bytes(left.pixel_type);
+    if (left.stride % size != 0 || right.stride % size != 0 || left.stride / size < config.cols ||
+        right.stride / size < config.cols)
+        return -1;
+    return 0;
+}
+
+int sgm_stage_cost_view(
+    const sgm_config_t &config,
+    const sgm_image_view_t &left,
+    const sgm_image_view_t &right,
+    sgm_workspace_t &workspace)
+{
+    if (left.pixel_type != right.pixel_type)
+        return -1;
+    SGM_VIEW_DISPATCH(stage_cost, left, right, workspace)
+    return 0;
+}
+
+int sgm_compute_view(
+    const sgm_config_t &config,
+    const sgm_image_view_t &left,
+    const sgm_image_view_t &right,
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    if (sgm_stage_cost_view(config, left, right, workspace) != 0)
+        return -1;
+    sgm_stage_aggregate(config, workspace);
+    sgm_stage_wta(config, disparity_output, workspace);
+    return 0;
+}
+
+int sgm_compute_hmi_view(
+    const sgm_config_t &config,
+    const sgm_image_view_t &left,
+    const sgm_image_view_t &right,
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace)
+{
+    if (left.pixel_type != right.pixel_type)
+        return -1;
+    SGM_VIEW_DISPATCH(compute_hmi, left, right, disparity_output, workspace)
+    return 0;
+}
+
+void sgm_cost_row(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int y, sgm_workspace_t &workspace)
+{
+    compute_sad_cost_row(left_pixels, config.cols, right_pixels, config.cols, workspace.cost_volume, y, config.cols,
+                         config.disp_range);
+}
+
+void sgm_aggregate_row(const sgm_config_t &config, int path, int y, sgm_workspace_t &workspace)
+{
+    // Stored cost volume: no images are read
+    aggregate_path_row(workspace.cost_volume, (const float *)0, 0, (const float *)0, 0, false,
+                       workspace.path_cost[path], path_dir_y[path], path_dir_x[path], y,
+                       config.rows, config.cols, config.disp_range, config.p1, config.p2);
+}
+
+void sgm_wta_row(const sgm_config_t &config, int y, int disparity_output[HEIGHT * WIDTH], sgm_workspace_t &workspace)
+{
+    select_disparity_wta_row(workspace.path_cost, disparity_output, y, config.cols, config.disp_range, config.num_paths);
+}
+
+#ifndef __SYNTHESIS__
+/* --- Host workspace allocation: only the buffers the reserved modes touch --- */
+
+/**
+ * @brief Allocates @p count elements into @p buffer unless it is already allocated.
+ */
+template <typename element_t>
+static bool reserve_buffer(element_t *&buffer, int count)
+{
+    if (!buffer)
+        buffer = new (std::nothrow) element_t[count];
+    return buffer != 0;
+}
+
+int sgm_reserve_workspace(sgm_workspace_t &workspace, const sgm_config_t &config)
+{
+    bool stored_paths = !config.memory_bounded && !config.single_sweep && config.num_paths != SGM_TWO_PASS_PATHS;
+    bool two_pass = !config.memory_bounded && config.num_paths == SGM_TWO_PASS_PATHS;
+    bool scaled = config.subsample > 1 || config.cost == SGM_COST_MI; // HMI runs its coarse levels subsampled
+    bool ok = true;
+
+    if (!recompute_mode(config))
+        ok = reserve_buffer(workspace.cost_volume, HEIGHT) && ok;
+    for (int r = 0; r < SGM_MAX_PATHS; r++)
+    {
+        if (stored_paths && r < config.num_paths)
+            ok = reserve_buffer(workspace.path_cost[r], HEIGHT) && ok;
+    }
+    // The forward sum is stored either as float or compressed (a quarter of the bytes), never both
+    if (two_pass && config.compress_step == 0)
+        ok = reserve_buffer(workspace.summed_cost, HEIGHT) && ok;
+    if (two_pass && config.compress_step > 0)
+    {
+        ok = reserve_buffer(workspace.summed_min, HEIGHT) && ok;
+        ok = reserve_buffer(workspace.summed_delta, HEIGHT) && ok;
+    }
+    if (fused_selection(config))
+        ok = reserve_buffer(workspace.line_buffer, 2) && ok;
+    if (config.memory_bounded)
+    {
+        ok = reserve_buffer(workspace.candidate_disparity, HEIGHT) && ok;
+        ok = reserve_buffer(workspace.candidate_cost, HEIGHT) && ok;
+    }
+    if (config.cost == SGM_COST_MI)
+    {
+        ok = reserve_buffer(workspace.mi_table, SGM_MI_LEVELS) && ok;
+        ok = reserve_buffer(workspace.mi_scratch, SGM_MI_LEVELS) && ok;
+    }
+    if (scaled)
+    {
+        ok = reserve_buffer(workspace.left_scaled, HEIGHT * WIDTH) && ok;
+        ok = reserve_buffer(workspace.right_scaled, HEIGHT * WIDTH) && ok;
+    }
+    if (scaled || fused_selection(config))
+        ok = reserve_buffer(workspace.disparity_scaled, HEIGHT * WIDTH) && ok;
+    return ok ? 0 : -1;
+}
+
+sgm_workspace_t *sgm_create_workspace(const sgm_config_t &config)
+{
+    sgm_workspace_t *workspace = new (std::nothrow) sgm_workspace_t();
+    if (workspace && sgm_reserve_workspace(*workspace, config) != 0)
+    {
+        sgm_destroy_workspace(workspace);
+        return 0;
+    }
+    return workspace;
+}
+
+void sgm_destroy_workspace(sgm_workspace_t *workspace)
+{
+    if (!workspace)
+        return;
+    delete[] workspace->cost_volume;
+    for (int r = 0; r < SGM_MAX_PATHS; r++)
+        delete[] workspace->path_cost[r];
+    delete[] workspace->summed_cost;
+    delete[] workspace->line_buffer;
+    delete[] workspace->summed_min;
+    delete[] workspace->summed_delta;
+    delete[] workspace->candidate_disparity;
+    delete[] workspace->candidate_cost;
+    delete[] workspace->mi_table;
+    delete[] workspace->mi_scratch;
+    delete[] workspace->left_scaled;
+    delete[] workspace->right_scaled;
+    delete[] workspace->disparity_scaled;
+    delete workspace;
+}
+
+/**
+ * @brief Bytes of @p count elements of @p buffer if it is allocated.
+ */
+template <typename element_t>
+static unsigned long buffer_bytes(const element_t *buffer, int count)
+{
+    return buffer ? (unsigned long)sizeof(element_t) * count : 0;
+}
+
+unsigned long sgm_workspace_bytes(const sgm_workspace_t &workspace)
+{
+    unsigned long bytes = buffer_bytes(workspace.cost_volume, HEIGHT);
+    for (int r = 0; r < SGM_MAX_PATHS; r++)
+        bytes += buffer_bytes(workspace.path_cost[r], HEIGHT);
+    bytes += buffer_bytes(workspace.summed_cost, HEIGHT) + buffer_bytes(workspace.line_buffer, 2);
+    bytes += buffer_bytes(workspace.summed_min, HEIGHT) + buffer_bytes(workspace.summed_delta, HEIGHT);
+    bytes += buffer_bytes(workspace.candidate_disparity, HEIGHT) + buffer_bytes(workspace.candidate_cost, HEIGHT);
+    bytes += buffer_bytes(workspace.mi_table, SGM_MI_LEVELS) + buffer_bytes(workspace.mi_scratch, SGM_MI_LEVELS);
+    bytes += buffer_bytes(workspace.left_scaled, HEIGHT * WIDTH) + buffer_bytes(workspace.right_scaled, HEIGHT * WIDTH);
+    bytes += buffer_bytes(workspace.disparity_scaled, HEIGHT * WIDTH);
+    return bytes;
+}
+#endif
+
+/**
+ * @brief Top-level HLS entry point for Semi-Global Matching (SGM).
+ * Performs matching cost calculation, 4-path aggregation, and Winner-Take-All disparity selection.
+ */
+void sgm_hls(
+    float left_pixels[HEIGHT * WIDTH],
+    float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH])
+{
+// AXI4-Master interfaces for high-bandwidth off-chip memory access
+#pragma HLS INTERFACE m_axi port = left_pixels offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = right_pixels offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = disparity_output offset = slave bundle = gmem
 // AXI4-Lite interface for IP core control and status
 #pragma HLS INTERFACE s_axilite port = return bundle = control
 
-    // On-chip memory allocation for cost volumes (requires BRAM/URAM resources)
+    // On-chip memory allocation for cost volumes (requires BRAM/URAM resources). The IP core keeps its own
+    // arrays: sgm_workspace_t is the host-side container of every mode's buffers.
     static float cost_volume[HEIGHT][WIDTH][MAX_DISP];
     static float path_left_to_right[HEIGHT][WIDTH][MAX_DISP];
     static float path_right_to_left[HEIGHT][WIDTH][MAX_DISP];
@@ -138,15 +1773,41 @@ void sgm_hls(
 #pragma HLS ARRAY_PARTITION variable = cost_volume cyclic factor = 8 dim = 3
 
     // 1. Matching Cost Computation
-    compute_sad_cost_hls(left_pixels, right_pixels, cost_volume);
+    {
+        SGM_PROFILE_KERNEL("cost_sad", SGM_COST_BYTES(HEIGHT, WIDTH, MAX_DISP, sizeof(float)),
+                           SGM_COST_OPS_PER_CELL * SGM_VOLUME_CELLS(HEIGHT, WIDTH, MAX_DISP));
+        compute_sad_cost_hls(left_pixels, WIDTH, right_pixels, WIDTH, cost_volume, HEIGHT, WIDTH, MAX_DISP);
+    }
 
-    // 2. 4-Path Cost Aggregation (Horizontal and Vertical directions)
-    aggregate_path_hls(cost_volume, path_left_to_right, 0, 1);
-    aggregate_path_hls(cost_volume, path_right_to_left, 0, -1);
-    aggregate_path_hls(cost_volume, path_top_to_bottom, 1, 0);
-    aggregate_path_hls(cost_volume, path_bottom_to_top, -1, 0);
+    // 2. 4-Path Cost Aggregation (Horizontal and Vertical directions); the stored volume is read, no images
+    {
+        SGM_PROFILE_KERNEL("aggregate_left_to_right", SGM_AGGREGATE_BYTES(HEIGHT, WIDTH, MAX_DISP, 0),
+                           SGM_AGGREGATE_OPS_PER_CELL * SGM_VOLUME_CELLS(HEIGHT, WIDTH, MAX_DISP));
+        aggregate_path_hls(cost_volume, left_pixels, WIDTH, right_pixels, WIDTH, false, path_left_to_right, 0, 1,
+                           HEIGHT, WIDTH, MAX_DISP, P1_PENALTY, P2_PENALTY);
+    }
+    {
+        SGM_PROFILE_KERNEL("aggregate_right_to_left", SGM_AGGREGATE_BYTES(HEIGHT, WIDTH, MAX_DISP, 0),
+                           SGM_AGGREGATE_OPS_PER_CELL * SGM_VOLUME_CELLS(HEIGHT, WIDTH, MAX_DISP));
+        aggregate_path_hls(cost_volume, left_pixels, WIDTH, right_pixels, WIDTH, false, path_right_to_left, 0, -1,
+                           HEIGHT, WIDTH, MAX_DISP, P1_PENALTY, P2_PENALTY);
+    }
+    {
+        SGM_PROFILE_KERNEL("aggregate_top_to_bottom", SGM_AGGREGATE_BYTES(HEIGHT, WIDTH, MAX_DISP, 0),
+                           SGM_AGGREGATE_OPS_PER_CELL * SGM_VOLUME_CELLS(HEIGHT, WIDTH, MAX_DISP));
+        aggregate_path_hls(cost_volume, left_pixels, WIDTH, right_pixels, WIDTH, false, path_top_to_bottom, 1, 0,
+                           HEIGHT, WIDTH, MAX_DISP, P1_PENALTY, P2_PENALTY);
+    }
+    {
+        SGM_PROFILE_KERNEL("aggregate_bottom_to_top", SGM_AGGREGATE_BYTES(HEIGHT, WIDTH, MAX_DISP, 0),
+                           SGM_AGGREGATE_OPS_PER_CELL * SGM_VOLUME_CELLS(HEIGHT, WIDTH, MAX_DISP));
+        aggregate_path_hls(cost_volume, left_pixels, WIDTH, right_pixels, WIDTH, false, path_bottom_to_top, -1, 0,
+                           HEIGHT, WIDTH, MAX_DISP, P1_PENALTY, P2_PENALTY);
+    }
 
     // 3. Final Summation and Winner-Take-All (WTA) Disparity Selection
+    SGM_PROFILE_KERNEL("wta", SGM_WTA_BYTES(HEIGHT, WIDTH, MAX_DISP, SGM_MAX_PATHS),
+                       SGM_WTA_OPS_PER_CELL * SGM_VOLUME_CELLS(HEIGHT, WIDTH, MAX_DISP));
     for (int y = 0; y < HEIGHT; y++)
     {
         for (int x = 0; x < WIDTH; x++)
@@ -9,15 +9,317 @@
  * @brief Hardware-oriented constraints and interface definitions for SGM IP Core.
  */
 
-/* --- Hardware Image Geometry --- */
+/* --- Hardware Image Geometry (synthesized maxima; override with -D for larger host builds) --- */
+#ifndef HEIGHT
 #define HEIGHT 240
+#endif
+#ifndef WIDTH
 #define WIDTH 272
+#endif
+#ifndef MAX_DISP
 #define MAX_DISP 16
+#endif
 
 /* --- SGM Energy Minimization Penalties --- */
 #define P1_PENALTY 8   // Penalty for small disparity changes (neighbor +/- 1)
 #define P2_PENALTY 128 // Penalty for large disparity discontinuities (> 1)
 
+/* --- Aggregation Directions (prefixes of this order select the 1/2/4-path variants) --- */
+#define SGM_MAX_PATHS 4 // Directions with their own stored path volume
+#define SGM_PATH_LEFT_TO_RIGHT 0
+#define SGM_PATH_TOP_TO_BOTTOM 1
+#define SGM_PATH_RIGHT_TO_LEFT 2
+#define SGM_PATH_BOTTOM_TO_TOP 3
+
+/* --- Two-Pass 8-Path Aggregation (forward sweep: L->R, T->B and both downward diagonals; backward sweep:
+ * the four reverse directions). Only their sum is stored, plus line buffers for the row-to-row paths. --- */
+#define SGM_TWO_PASS_PATHS 8
+#define SGM_LINE_PATHS 3 // Directions per sweep that read the previous row (also used by single_sweep)
+#define SGM_DELTA_MAX 255 // Saturation of the 8-bit compressed forward sum (deltas above decode as the cap)
+#ifndef SGM_BOUNDED_CANDIDATES
+#define SGM_BOUNDED_CANDIDATES 3 // Memory-bounded 8-path mode: disparity candidates kept per pixel and sweep
+#endif
+
+/* --- Matching Cost Types (sgm_config_t::cost) --- */
+#define SGM_COST_AD 0 // Absolute intensity difference
+#define SGM_COST_MI 1 // Mutual information lookup table in workspace.mi_table (see sgm_stage_mi_table)
+#define SGM_MI_LEVELS 256    // Intensity levels per image indexing the MI table (8-bit input)
+#define SGM_MI_SCALE 8.0f    // MI table cost units per nat of -mi
+#define SGM_MI_MAX_COST 999  // MI table saturation (stays below the 1000.0f out-of-frame cost)
+#define SGM_HMI_COARSE 4     // Subsampling factor of the AD bootstrap level of sgm_compute_hmi
+
+/* --- Color Input --- */
+#define SGM_RGB_CHANNELS 3 // Interleaved 8-bit R, G, B samples per pixel (sgm_stage_cost_rgb input)
+
+/* --- Image View Pixel Types (sgm_image_view_t::pixel_type) --- */
+#define SGM_PIXEL_U8 0  // unsigned char
+#define SGM_PIXEL_U16 1 // unsigned short (costs in its intensity units: scale p1 / p2 for > 8-bit data)
+#define SGM_PIXEL_F32 2 // float
+
+/**
+ * @brief Runtime configuration of the SGM core (AXI4-Lite register view for host-driven runs).
+ * Frame geometry may be smaller than the synthesized HEIGHT x WIDTH x MAX_DISP maxima.
+ */
+typedef struct
+{
+    int rows;       // Active frame height (<= HEIGHT)
+    int cols;       // Active frame width (<= WIDTH)
+    int disp_range; // Active disparity candidates (<= MAX_DISP)
+    int num_paths;  // 1 (L->R), 2 (+ T->B), 4 (+ R->L, B->T) or 8 (two-pass, + diagonals) directions
+    int subsample;  // Processing stride: frame is box-downsampled by this factor, disparities upsampled back
+    int p1;         // Small disparity change penalty
+    int p2;         // Large disparity change penalty
+    int compress_step; // 8 paths: 0 stores the forward sum as float, N > 0 as per-pixel min + 8-bit deltas of N
+    int recompute_cost; // 1: aggregation recomputes the AD cost from the images, cost_volume is never touched
+    int single_sweep;   // 1: forward directions only (4 paths: L->R, T->B, both downward diagonals) in one sweep
+    int memory_bounded; // 8 paths: 1 keeps a few candidates per pixel instead of the summed volume (eSGM)
+    int mgm;            // 1: each path is an MGM quadrant sweep (left/right and upper/lower predecessor averaged)
+    int cost;           // SGM_COST_AD or SGM_COST_MI (workspace.mi_table must be built first)
+} sgm_config_t;
+
+/**
+ * @brief Gray input frame read in place by the cost stage: any row stride, 8-bit, 16-bit or float pixels.
+ * Geometry comes from sgm_config_t (rows x cols starting at data); a region of interest of a larger buffer
+ * is a view whose data points at the ROI origin (see sgm_view_roi).
+ */
+typedef struct
+{
+    const void *data; // Pixel (0, 0) of the view
+    int pixel_type;   // SGM_PIXEL_*
+    int stride;       // Bytes between rows, a multiple of the pixel size
+} sgm_image_view_t;
+
+/**
+ * @brief Cost volume and path buffers of one SGM instance for host builds. The IP core (sgm_hls) declares its
+ * own static arrays. Each buffer is heap-allocated only when a reserved configuration touches it (null
+ * otherwise), so a workspace costs the footprint of its modes: see sgm_create_workspace.
+ */
+typedef struct
+{
+    float (*cost_volume)[WIDTH][MAX_DISP];                // [HEIGHT]; stored-cost modes
+    float (*path_cost[SGM_MAX_PATHS])[WIDTH][MAX_DISP];   // [HEIGHT] each; stored 1/2/4-path modes
+    float (*summed_cost)[WIDTH][MAX_DISP];                // [HEIGHT]; 8 paths, compress_step 0: float forward sum
+    float (*line_buffer)[SGM_LINE_PATHS][WIDTH][MAX_DISP]; // [2]; line-buffered modes: previous / current row per path
+    float (*summed_min)[WIDTH];                           // [HEIGHT]; compressed forward sum: per-pixel minimum
+    unsigned char (*summed_delta)[WIDTH][MAX_DISP];       // [HEIGHT]; compressed forward sum: saturated deltas
+    short (*candidate_disparity)[WIDTH][2 * SGM_BOUNDED_CANDIDATES]; // [HEIGHT]; memory-bounded: forward, backward
+    float (*candidate_cost)[WIDTH][2 * SGM_BOUNDED_CANDIDATES];      // [HEIGHT]; memory-bounded: their path sums
+    float (*mi_table)[SGM_MI_LEVELS];   // [SGM_MI_LEVELS]; MI cost: C(left level, right level)
+    float (*mi_scratch)[SGM_MI_LEVELS]; // [SGM_MI_LEVELS]; MI table construction: smoothing pass
+    float *left_scaled;     // [HEIGHT * WIDTH]; subsampled reference image
+    float *right_scaled;    // [HEIGHT * WIDTH]; subsampled target image
+    int *disparity_scaled;  // [HEIGHT * WIDTH]; disparity at subsampled resolution / fused selection
+    sgm_image_view_t left_view;  // Recompute modes: images read in place by sgm_stage_aggregate (the caller's
+    sgm_image_view_t right_view; // frames, or left_scaled / right_scaled when subsampled)
+} sgm_workspace_t;
+
+/**
+ * @brief Returns the configuration synthesized into the IP core (full frame, 4 paths, default penalties).
+ */
+sgm_config_t sgm_default_config();
+
+/**
+ * @brief Validates a runtime configuration against the synthesized maxima.
+ * @return 0 if valid, otherwise -1.
+ */
+int sgm_check_config(const sgm_config_t &config);
+
+/* --- Host workspace allocation --- */
+
+/**
+ * @brief Allocates a workspace holding the buffers @p config needs (stored cost and path volumes, the float or
+ * the compressed 8-path sum but never both, line buffers, memory-bounded candidates, MI tables, subsampled
+ * planes).
+ * @return Workspace for sgm_destroy_workspace, or 0 if an allocation failed.
+ */
+sgm_workspace_t *sgm_create_workspace(const sgm_config_t &config);
+
+/**
+ * @brief Adds the buffers @p config needs that @p workspace does not hold yet (existing ones are kept), so one
+ * workspace can serve several configurations. Not thread-safe against a computation on the same workspace.
+ * @return 0, or -1 if an allocation failed (buffers allocated so far are kept).
+ */
+int sgm_reserve_workspace(sgm_workspace_t &workspace, const sgm_config_t &config);
+
+/**
+ * @brief Releases a workspace from sgm_create_workspace and all its buffers (null is ignored).
+ */
+void sgm_destroy_workspace(sgm_workspace_t *workspace);
+
+/**
+ * @brief Bytes held by the allocated buffers of @p workspace.
+ */
+unsigned long sgm_workspace_bytes(const sgm_workspace_t &workspace);
+
+/**
+ * @brief Configurable SGM pipeline: cost, path aggregation, WTA.
+ * @param config           Validated runtime configuration (see sgm_check_config).
+ * @param left_pixels      Reference image, config.rows x config.cols, densely packed.
+ * @param right_pixels     Target image, same geometry.
+ * @param disparity_output Disparity map, same geometry.
+ * @param workspace        Buffers owned by the caller, reserved for @p config; not shared between concurrent
+ *                         calls.
+ */
+void sgm_compute(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/* --- Individual pipeline stages (sgm_compute runs them in this order on one workspace) --- */
+
+/**
+ * @brief Subsampling (if configured) and matching cost into workspace.cost_volume. With recompute_cost or
+ * memory_bounded the volume is not written: sgm_stage_aggregate reads the images in place, so they must stay
+ * valid until it returns.
+ */
+void sgm_stage_cost(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief Builds the mutual-information cost table workspace.mi_table from a disparity estimate: joint
+ * histogram of left(x) / right(x - d) intensities over the full-resolution frame, Gaussian-smoothed
+ * entropies, C(i, k) = -mi(i, k) shifted to zero, scaled by SGM_MI_SCALE and saturated at SGM_MI_MAX_COST.
+ * @param disparity  Full-resolution estimate (config.rows x config.cols), e.g. from a coarser level.
+ */
+void sgm_stage_mi_table(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    const int disparity[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief Hierarchical mutual information (HMI): an AD pass at subsample SGM_HMI_COARSE bootstraps the
+ * disparity, then each level halves the subsampling down to config.subsample, matching with the MI table
+ * built from the previous level's map. config.cost is ignored; the remaining fields apply to every level.
+ * The workspace must be reserved for @p config with cost = SGM_COST_MI.
+ */
+void sgm_compute_hmi(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief Color variant of sgm_stage_cost: C(p, d) is the mean per-channel AD of interleaved 8-bit RGB frames,
+ * written into the same workspace.cost_volume (one volume, no per-channel copies). Same scale as the gray AD,
+ * so the default penalties apply. Requires a configuration accepted by sgm_check_rgb_config.
+ */
+void sgm_stage_cost_rgb(
+    const sgm_config_t &config,
+    const unsigned char left_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    const unsigned char right_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief sgm_check_config plus the color cost constraints: AD, full resolution (subsample 1) and a stored
+ * cost volume (no recompute_cost / memory_bounded, which derive the cost from gray images).
+ * @return 0 if valid, otherwise -1.
+ */
+int sgm_check_rgb_config(const sgm_config_t &config);
+
+/**
+ * @brief sgm_compute with the color cost: sgm_stage_cost_rgb, sgm_stage_aggregate, sgm_stage_wta.
+ */
+void sgm_compute_rgb(
+    const sgm_config_t &config,
+    const unsigned char left_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    const unsigned char right_rgb[HEIGHT * WIDTH * SGM_RGB_CHANNELS],
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/* --- Image views (strided / ROI / 8-bit, 16-bit or float frames, no repacking) --- */
+
+/**
+ * @brief View of @p data with pixel type SGM_PIXEL_* and a row stride in bytes.
+ */
+sgm_image_view_t sgm_make_view(const void *data, int pixel_type, int stride);
+
+/**
+ * @brief Sub-view starting at column @p x, row @p y of @p view (same stride and pixel type).
+ */
+sgm_image_view_t sgm_view_roi(const sgm_image_view_t &view, int x, int y);
+
+/**
+ * @brief sgm_check_config plus the view constraints: non-null data, known pixel type shared by both views,
+ * stride a multiple of the pixel size covering config.cols pixels, and 8-bit intensities for the MI cost
+ * (no SGM_PIXEL_U16).
+ * @return 0 if valid, otherwise -1.
+ */
+int sgm_check_view_config(const sgm_config_t &config, const sgm_image_view_t &left, const sgm_image_view_t &right);
+
+/**
+ * @brief sgm_stage_cost reading the views directly in the cost kernel (subsampling, the recompute modes and
+ * the MI table read them in place too).
+ * @return 0, or -1 (nothing computed) if the views' pixel type is unknown or differs between them.
+ */
+int sgm_stage_cost_view(
+    const sgm_config_t &config,
+    const sgm_image_view_t &left,
+    const sgm_image_view_t &right,
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief sgm_compute on image views (requires sgm_check_view_config).
+ * @return 0, or -1 as sgm_stage_cost_view.
+ */
+int sgm_compute_view(
+    const sgm_config_t &config,
+    const sgm_image_view_t &left,
+    const sgm_image_view_t &right,
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief sgm_compute_hmi on image views (8-bit or float; checked by sgm_check_view_config with cost = MI).
+ * @return 0, or -1 as sgm_stage_cost_view.
+ */
+int sgm_compute_hmi_view(
+    const sgm_config_t &config,
+    const sgm_image_view_t &left,
+    const sgm_image_view_t &right,
+    int disparity_output[HEIGHT * WIDTH],
+    sgm_workspace_t &workspace);
+
+/**
+ * @brief Path aggregation of workspace.cost_volume into workspace.path_cost.
+ */
+void sgm_stage_aggregate(const sgm_config_t &config, sgm_workspace_t &workspace);
+
+/**
+ * @brief Path summation, WTA selection and upsampling (if configured) into the disparity map.
+ * In 8-path and single-sweep mode the selection is fused into the sweep of sgm_stage_aggregate.
+ */
+void sgm_stage_wta(const sgm_config_t &config, int disparity_output[HEIGHT * WIDTH], sgm_workspace_t &workspace);
+
+/* --- Row-granular kernels for host row pipelines (full resolution, subsample 1, up to 4 paths, stored cost) --- */
+
+/**
+ * @brief Matching cost of row y.
+ */
+void sgm_cost_row(
+    const sgm_config_t &config,
+    const float left_pixels[HEIGHT * WIDTH],
+    const float right_pixels[HEIGHT * WIDTH],
+    int y, sgm_workspace_t &workspace);
+
+/**
+ * @brief Aggregates row y of direction @p path (SGM_PATH_*). Needs cost row y and, for vertical paths, the
+ * previous row of the same path (y - 1 top-to-bottom, y + 1 bottom-to-top).
+ */
+void sgm_aggregate_row(const sgm_config_t &config, int path, int y, sgm_workspace_t &workspace);
+
+/**
+ * @brief WTA selection of row y once every active path holds that row.
+ */
+void sgm_wta_row(const sgm_config_t &config, int y, int disparity_output[HEIGHT * WIDTH], sgm_workspace_t &workspace);
+
 /**
  * @brief Top-level entry point for the Semi-Global Matching (SGM) hardware accelerator.
  * @param left_pixels  Input AXI-Master port for the reference image.
@@ -0,0 +1,328 @@
+#ifndef SGM_PROFILE_H
+#define SGM_PROFILE_H
+
+/**
+ * @file sgm_profile.h
+ * @brief Host-side per-stage profiler for C-Simulation and software builds of the SGM core.
+ *
+ * Every pipeline stage is wrapped in SGM_PROFILE_STAGE(name), or SGM_PROFILE_KERNEL(name, bytes, ops)
+ * when the stage also declares its compulsory memory traffic and arithmetic work for roofline analysis.
+ * Both macros expand to nothing during synthesis (__SYNTHESIS__) and unless SGM_PROFILE is defined,
+ * so the IP core is unaffected and the traffic expressions are never evaluated.
+ *
+ * With SGM_PROFILE on Linux, each stage additionally samples cycles, retired instructions,
+ * last-level-cache references and misses through perf_event_open(2). If the kernel refuses the
+ * counters (perf_event_paranoid, containers, VMs) the profiler silently degrades to wall time only.
+ */
+
+#if defined(SGM_PROFILE) && !defined(__SYNTHESIS__)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* --- Hardware Counter Set --- */
+enum sgm_counter_id
+{
+    SGM_COUNTER_CYCLES = 0,
+    SGM_COUNTER_INSTRUCTIONS,
+    SGM_COUNTER_LLC_REFERENCES,
+    SGM_COUNTER_LLC_MISSES,
+    SGM_NUM_COUNTERS
+};
+
+#define SGM_CACHE_LINE_BYTES 64 // Used to estimate DRAM traffic from LLC misses
+
+/**
+ * @brief Accumulated statistics of one named pipeline stage.
+ */
+struct sgm_stage_stats
+{
+    std::string name;
+    long calls;
+    double seconds;
+    double bytes; // Compulsory off-chip traffic declared by the stage (accumulated over calls)
+    double ops;   // Arithmetic operations declared by the stage (accumulated over calls)
+    uint64_t counters[SGM_NUM_COUNTERS];
+    bool counter_valid[SGM_NUM_COUNTERS];
+};
+
+/**
+ * @brief Per-thread perf_event group (cycles leader + instructions + LLC refs/misses).
+ * perf_event_open with pid = 0, cpu = -1 counts only the calling thread, so one group is kept per thread.
+ */
+class sgm_perf_group
+{
+public:
+    sgm_perf_group() : leader_fd(-1), num_open(0)
+    {
+        for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+            slot[i] = -1;
+#ifdef __linux__
+        static const uint64_t configs[SGM_NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+
+        for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+        {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = (leader_fd < 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, leader_fd, 0);
+            if (fd < 0)
+                continue; // Counter unsupported or access denied: report it as unavailable
+            if (leader_fd < 0)
+                leader_fd = fd;
+            fds[num_open] = fd;
+            slot[i] = num_open++;
+        }
+
+        if (leader_fd >= 0)
+        {
+            ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    ~sgm_perf_group()
+    {
+#ifdef __linux__
+        for (int i = 0; i < num_open; i++)
+            close(fds[i]);
+#endif
+    }
+
+    bool available() const { return leader_fd >= 0; }
+
+    bool valid(int counter) const { return slot[counter] >= 0; }
+
+    /**
+     * @brief Reads all counters of the group, scaled for multiplexing.
+     * @param values  Output indexed by sgm_counter_id (unavailable counters read as zero).
+     */
+    bool read_all(uint64_t values[SGM_NUM_COUNTERS]) const
+    {
+        for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+            values[i] = 0;
+#ifdef __linux__
+        if (leader_fd < 0)
+            return false;
+
+        // Layout for PERF_FORMAT_GROUP | TIME_ENABLED | TIME_RUNNING: nr, enabled, running, value[nr]
+        uint64_t buffer[3 + SGM_NUM_COUNTERS];
+        if (::read(leader_fd, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t)))
+            return false;
+
+        double scale = (buffer[2] > 0) ? (double)buffer[1] / (double)buffer[2] : 1.0;
+        for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+        {
+            if (slot[i] >= 0 && (uint64_t)slot[i] < buffer[0])
+                values[i] = (uint64_t)((double)buffer[3 + slot[i]] * scale);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    int leader_fd;
+    int num_open;
+    int fds[SGM_NUM_COUNTERS];
+    int slot[SGM_NUM_COUNTERS];
+};
+
+/**
+ * @brief Process-wide table of stage statistics, in first-seen order.
+ */
+class sgm_profiler
+{
+public:
+    static sgm_profiler &instance()
+    {
+        static sgm_profiler profiler;
+        return profiler;
+    }
+
+    static sgm_perf_group &thread_counters()
+    {
+        static thread_local sgm_perf_group group;
+        return group;
+    }
+
+    void record(const char *name, double seconds, double bytes, double ops,
+                const uint64_t delta[SGM_NUM_COUNTERS], const sgm_perf_group &group)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sgm_stage_stats *entry = 0;
+        for (size_t i = 0; i < stages.size(); i++)
+        {
+            if (stages[i].name == name)
+            {
+                entry = &stages[i];
+                break;
+            }
+        }
+        if (!entry)
+        {
+            sgm_stage_stats fresh;
+            fresh.name = name;
+            fresh.calls = 0;
+            fresh.seconds = 0.0;
+            fresh.bytes = 0.0;
+            fresh.ops = 0.0;
+            for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+            {
+                fresh.counters[i] = 0;
+                fresh.counter_valid[i] = group.valid(i);
+            }
+            stages.push_back(fresh);
+            entry = &stages.back();
+        }
+
+        entry->calls++;
+        entry->seconds += seconds;
+        entry->bytes += bytes;
+        entry->ops += ops;
+        for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+        {
+            entry->counters[i] += delta[i];
+            entry->counter_valid[i] = entry->counter_valid[i] && group.valid(i);
+        }
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stages.clear();
+    }
+
+    std::vector<sgm_stage_stats> snapshot()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stages;
+    }
+
+    /**
+     * @brief Prints one line per stage: time, and when their counters are available cycles, IPC, LLC miss
+     * ratio and a lower-bound DRAM bandwidth estimate (LLC misses x cache line / time; prefetches and
+     * write-backs are not counted). A column whose counters could not be opened prints "-".
+     */
+    void report(std::ostream &os)
+    {
+        std::vector<sgm_stage_stats> rows = snapshot();
+        char line[256];
+
+        std::snprintf(line, sizeof(line), "%-24s %6s %10s %10s %8s %8s %10s %12s\n",
+                      "stage", "calls", "total_ms", "ms/call", "Gcycles", "IPC", "LLC_miss%", "min_est_GB/s");
+        os << line;
+
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            const sgm_stage_stats &s = rows[i];
+            double total_ms = s.seconds * 1e3;
+            double call_ms = (s.calls > 0) ? total_ms / s.calls : 0.0;
+            const uint64_t *c = s.counters;
+            const bool *valid = s.counter_valid;
+
+            char cycles[16], ipc[16], miss_ratio[16], dram_gbs[16];
+            format_counter(cycles, valid[SGM_COUNTER_CYCLES], "%8.3f", c[SGM_COUNTER_CYCLES] / 1e9);
+            format_counter(ipc, valid[SGM_COUNTER_CYCLES] && valid[SGM_COUNTER_INSTRUCTIONS] && c[SGM_COUNTER_CYCLES] > 0,
+                           "%8.2f", (double)c[SGM_COUNTER_INSTRUCTIONS] / (double)c[SGM_COUNTER_CYCLES]);
+            format_counter(miss_ratio,
+                           valid[SGM_COUNTER_LLC_REFERENCES] && valid[SGM_COUNTER_LLC_MISSES] &&
+                               c[SGM_COUNTER_LLC_REFERENCES] > 0,
+                           "%10.2f", 100.0 * (double)c[SGM_COUNTER_LLC_MISSES] / (double)c[SGM_COUNTER_LLC_REFERENCES]);
+            format_counter(dram_gbs, valid[SGM_COUNTER_LLC_MISSES] && s.seconds > 0, "%12.2f",
+                           (double)c[SGM_COUNTER_LLC_MISSES] * SGM_CACHE_LINE_BYTES / s.seconds / 1e9);
+
+            std::snprintf(line, sizeof(line), "%-24s %6ld %10.3f %10.3f %8s %8s %10s %12s\n",
+                          s.name.c_str(), s.calls, total_ms, call_ms, cycles, ipc, miss_ratio, dram_gbs);
+            os << line;
+        }
+    }
+
+private:
+    /** @brief Formats one derived column, or "-" when an input counter was unavailable. */
+    static void format_counter(char text[16], bool valid, const char *format, double value)
+    {
+        if (valid)
+            std::snprintf(text, 16, format, value);
+        else
+            std::snprintf(text, 16, "%s", "-");
+    }
+
+    std::mutex mutex;
+    std::vector<sgm_stage_stats> stages;
+};
+
+/**
+ * @brief RAII scope measuring one stage invocation on the calling thread.
+ */
+class sgm_stage_scope
+{
+public:
+    explicit sgm_stage_scope(const char *stage_name, double stage_bytes = 0.0, double stage_ops = 0.0)
+        : name(stage_name), bytes(stage_bytes), ops(stage_ops)
+    {
+        sgm_profiler::thread_counters().read_all(start_counters);
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    ~sgm_stage_scope()
+    {
+        std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+        const sgm_perf_group &group = sgm_profiler::thread_counters();
+        uint64_t end_counters[SGM_NUM_COUNTERS];
+        group.read_all(end_counters);
+
+        uint64_t delta[SGM_NUM_COUNTERS];
+        for (int i = 0; i < SGM_NUM_COUNTERS; i++)
+            delta[i] = (end_counters[i] >= start_counters[i]) ? end_counters[i] - start_counters[i] : 0;
+
+        double seconds = std::chrono::duration<double>(end_time - start_time).count();
+        sgm_profiler::instance().record(name, seconds, bytes, ops, delta, group);
+    }
+
+private:
+    const char *name;
+    double bytes;
+    double ops;
+    std::chrono::steady_clock::time_point start_time;
+    uint64_t start_counters[SGM_NUM_COUNTERS];
+};
+
+#define SGM_PROFILE_CONCAT_INNER(a, b) a##b
+#define SGM_PROFILE_CONCAT(a, b) SGM_PROFILE_CONCAT_INNER(a, b)
+#define SGM_PROFILE_STAGE(name) sgm_stage_scope SGM_PROFILE_CONCAT(sgm_stage_scope_, __LINE__)(name)
+#define SGM_PROFILE_KERNEL(name, bytes, ops) \
+    sgm_stage_scope SGM_PROFILE_CONCAT(sgm_stage_scope_, __LINE__)(name, (double)(bytes), (double)(ops))
+
+#else
+
+#define SGM_PROFILE_STAGE(name)
+#define SGM_PROFILE_KERNEL(name, bytes, ops)
+
+#endif
+
+#endif
@@ -0,0 +1,298 @@
+#include "sgm_hls.h"
+#include "disparity_metrics.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file accuracy_tb.cpp
+ * @brief Accuracy-vs-speed regression harness: runs every engine configuration against Ground_Truth.png.
+ *
+ * Reports bad-pixel rates (> 1 px, > 2 px), RMSE and throughput per configuration. On the first run the
+ * results are stored as the baseline; later runs fail (exit code 1) when a configuration loses more than
+ * the configured tolerance, so optimizations that degrade quality are caught automatically. Configurations
+ * missing from the baseline are appended to it; delete the file to re-record all of them.
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#ifndef RESULT_PATH
+#define RESULT_PATH "../../../results/"
+#endif
+
+#ifndef GT_PATH
+#define GT_PATH "../../../data/raw/Ground_Truth.png"
+#endif
+
+// Full-resolution color pair (left.png / right.png) for the raw-input gray and RGB cases
+#ifndef RAW_PATH
+#define RAW_PATH "../../../data/raw/"
+#endif
+
+// Stored intensity levels per pixel of disparity at ground-truth resolution (Ground_Truth.png: 4)
+#ifndef GT_SCALE
+#define GT_SCALE 4.0
+#endif
+
+#ifndef SGM_ACCURACY_ITERATIONS
+#define SGM_ACCURACY_ITERATIONS 3
+#endif
+
+// Allowed degradation before a configuration is flagged: percentage points and relative RMSE
+#define SGM_BAD_PIXEL_TOLERANCE 0.5
+#define SGM_RMSE_TOLERANCE 0.02
+
+/**
+ * @brief Input of a configuration: the preprocessed gray stream, the raw color pair area-resampled to
+ * the processing grid as 8-bit gray (float input) or interleaved 8-bit RGB (sgm_compute_rgb), or the gray
+ * stream with a different camera response on the right image (gamma, gain and offset).
+ */
+enum harness_source
+{
+    SOURCE_PIXEL_TEXT = 0,
+    SOURCE_RAW_GRAY,
+    SOURCE_RAW_RGB,
+    SOURCE_RADIOMETRIC
+};
+
+/**
+ * @brief One engine configuration under test.
+ */
+struct harness_case
+{
+    const char *name;
+    const char *cost_type;
+    const char *precision;
+    int num_paths;
+    int subsample;
+    int compress_step;
+    int recompute_cost;
+    int single_sweep;
+    int memory_bounded;
+    int mgm;
+    int hmi; // 1: hierarchical mutual information (sgm_compute_hmi)
+    harness_source source;
+};
+
+static const harness_case harness_cases[] = {
+    {"ad_f32_1path", "AD", "float32", 1, 1, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_2path", "AD", "float32", 2, 1, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_4path", "AD", "float32", 4, 1, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_8path", "AD", "float32", 8, 1, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_u8d_8path", "AD", "u8delta", 8, 1, 1, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_u8d4_8path", "AD", "u8delta4", 8, 1, 4, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_4path_rc", "AD-rc", "float32", 4, 1, 0, 1, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_8path_rc", "AD-rc", "float32", 8, 1, 0, 1, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_2path_ss", "AD", "float32", 2, 1, 0, 0, 1, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_4path_ss", "AD", "float32", 4, 1, 0, 0, 1, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_8path_mb", "AD-rc", "float32", 8, 1, 0, 0, 0, 1, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_2path_mgm", "AD", "float32", 2, 1, 0, 0, 0, 0, 1, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_4path_mgm", "AD", "float32", 4, 1, 0, 0, 0, 0, 1, 0, SOURCE_PIXEL_TEXT},
+    {"ad_raw_4path", "AD", "float32", 4, 1, 0, 0, 0, 0, 0, 0, SOURCE_RAW_GRAY},
+    {"rgb_raw_4path", "RGB", "float32", 4, 1, 0, 0, 0, 0, 0, 0, SOURCE_RAW_RGB},
+    {"ad_raw_8path", "AD", "float32", 8, 1, 0, 0, 0, 0, 0, 0, SOURCE_RAW_GRAY},
+    {"rgb_raw_8path", "RGB", "float32", 8, 1, 0, 0, 0, 0, 0, 0, SOURCE_RAW_RGB},
+    {"hmi_f32_4path", "HMI", "float32", 4, 1, 0, 0, 0, 0, 0, 1, SOURCE_PIXEL_TEXT},
+    {"hmi_f32_8path", "HMI", "float32", 8, 1, 0, 0, 0, 0, 0, 1, SOURCE_PIXEL_TEXT},
+    {"ad_f32_4path_radio", "AD", "float32", 4, 1, 0, 0, 0, 0, 0, 0, SOURCE_RADIOMETRIC},
+    {"hmi_f32_4path_radio", "HMI", "float32", 4, 1, 0, 0, 0, 0, 0, 1, SOURCE_RADIOMETRIC},
+    {"ad_f32_1path_sub2", "AD", "float32", 1, 2, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_2path_sub2", "AD", "float32", 2, 2, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_4path_sub2", "AD", "float32", 4, 2, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+    {"ad_f32_8path_sub2", "AD", "float32", 8, 2, 0, 0, 0, 0, 0, 0, SOURCE_PIXEL_TEXT},
+};
+
+/**
+ * @brief Quality and speed of one configuration.
+ */
+struct harness_result
+{
+    sgm_disparity_metrics metrics;
+    double mpix_per_s;
+};
+
+static std::map<std::string, harness_result> load_baseline(const std::string &path)
+{
+    std::map<std::string, harness_result> baseline;
+    std::ifstream stream(path.c_str());
+    std::string line;
+    std::getline(stream, line); // Header
+    while (std::getline(stream, line))
+    {
+        std::istringstream fields(line);
+        std::string name, cell;
+        harness_result entry = {{0, 0.0, 0.0, 0.0, 0.0}, 0.0};
+        std::getline(fields, name, ',');
+        std::getline(fields, cell, ',');
+        entry.metrics.bad1 = std::atof(cell.c_str());
+        std::getline(fields, cell, ',');
+        entry.metrics.bad2 = std::atof(cell.c_str());
+        std::getline(fields, cell, ',');
+        entry.metrics.bad2_in_range = std::atof(cell.c_str());
+        std::getline(fields, cell, ',');
+        entry.metrics.rmse = std::atof(cell.c_str());
+        if (!name.empty())
+            baseline[name] = entry;
+    }
+    return baseline;
+}
+
+int main()
+{
+    std::string error;
+    sgm_image left, right, ground_truth_raw;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error) ||
+        !sgm_read_png(GT_PATH, ground_truth_raw, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    sgm_image ground_truth = sgm_prepare_ground_truth(ground_truth_raw, WIDTH, HEIGHT, GT_SCALE);
+
+    // Raw pair on the processing grid, both rounded to 8 bit so gray and color differ only in the cost
+    sgm_image left_raw, right_raw;
+    if (!sgm_read_png(std::string(RAW_PATH) + "left.png", left_raw, error) ||
+        !sgm_read_png(std::string(RAW_PATH) + "right.png", right_raw, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    std::vector<unsigned char> left_rgb, right_rgb, left_gray8, right_gray8;
+    sgm_to_rgb8(sgm_resize_area(left_raw, WIDTH, HEIGHT, false), left_rgb);
+    sgm_to_rgb8(sgm_resize_area(right_raw, WIDTH, HEIGHT, false), right_rgb);
+    sgm_to_rgb8(sgm_resize_area(sgm_to_gray(left_raw), WIDTH, HEIGHT, false), left_gray8);
+    sgm_to_rgb8(sgm_resize_area(sgm_to_gray(right_raw), WIDTH, HEIGHT, false), right_gray8);
+    std::vector<float> left_gray(HEIGHT * WIDTH), right_gray(HEIGHT * WIDTH), right_radiometric(HEIGHT * WIDTH);
+    for (int i = 0; i < HEIGHT * WIDTH; i++)
+    {
+        left_gray[i] = left_gray8[i * SGM_RGB_CHANNELS];
+        right_gray[i] = right_gray8[i * SGM_RGB_CHANNELS];
+        right_radiometric[i] = std::floor(255.0f * std::pow(right.pixels[i] / 255.0f, 0.6f) * 0.8f + 20.0f + 0.5f);
+    }
+
+    sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config()); // Reserved per case below
+    int *disparity_output = new int[HEIGHT * WIDTH];
+
+    std::string baseline_path = std::string(RESULT_PATH) + "accuracy_baseline.csv";
+    std::map<std::string, harness_result> baseline = load_baseline(baseline_path);
+    bool have_baseline = !baseline.empty();
+
+    std::cout << ">>> SGM Accuracy-vs-Speed Harness (" << WIDTH << "x" << HEIGHT << ", " << MAX_DISP
+              << " disparities, baseline: " << (have_baseline ? baseline_path : std::string("none, recording")) << ")"
+              << std::endl;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-20s %-5s %-8s %5s %4s %8s %8s %10s %8s %9s %s\n",
+                  "config", "cost", "prec", "paths", "sub", "bad1%", "bad2%", "bad2_rng%", "rmse", "Mpix/s", "status");
+    std::cout << line;
+
+    std::ostringstream csv;
+    csv << "config,bad1,bad2,bad2_in_range,rmse,mpix_per_s\n";
+    int regressions = 0;
+    int recorded = 0;
+
+    for (size_t c = 0; c < sizeof(harness_cases) / sizeof(harness_cases[0]); c++)
+    {
+        const harness_case &test = harness_cases[c];
+        sgm_config_t config = sgm_default_config();
+        config.num_paths = test.num_paths;
+        config.subsample = test.subsample;
+        config.compress_step = test.compress_step;
+        config.recompute_cost = test.recompute_cost;
+        config.single_sweep = test.single_sweep;
+        config.memory_bounded = test.memory_bounded;
+        config.mgm = test.mgm;
+        bool color = test.source == SOURCE_RAW_RGB;
+        if ((color ? sgm_check_rgb_config(config) : sgm_check_config(config)) != 0)
+        {
+            std::cerr << "CRITICAL ERROR: invalid configuration " << test.name << std::endl;
+            return -1;
+        }
+        sgm_config_t reserved = config;
+        reserved.cost = test.hmi ? SGM_COST_MI : reserved.cost;
+        if (!workspace || sgm_reserve_workspace(*workspace, reserved) != 0)
+        {
+            std::cerr << "CRITICAL ERROR: cannot allocate the workspace of " << test.name << std::endl;
+            return -1;
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        const float *left_pixels = (test.source == SOURCE_RAW_GRAY) ? &left_gray[0] : &left.pixels[0];
+        const float *right_pixels = (test.source == SOURCE_RAW_GRAY)      ? &right_gray[0]
+                                    : (test.source == SOURCE_RADIOMETRIC) ? &right_radiometric[0]
+                                                                          : &right.pixels[0];
+        for (int iteration = 0; iteration < SGM_ACCURACY_ITERATIONS; iteration++)
+        {
+            if (color)
+                sgm_compute_rgb(config, &left_rgb[0], &right_rgb[0], disparity_output, *workspace);
+            else if (test.hmi)
+                sgm_compute_hmi(config, left_pixels, right_pixels, disparity_output, *workspace);
+            else
+                sgm_compute(config, left_pixels, right_pixels, disparity_output, *workspace);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        harness_result result;
+        result.metrics = sgm_evaluate_disparity(disparity_output, ground_truth, config.disp_range);
+        result.mpix_per_s = (double)WIDTH * HEIGHT * SGM_ACCURACY_ITERATIONS / seconds / 1e6;
+
+        const char *status = "recorded";
+        harness_result stored = result;
+        std::map<std::string, harness_result>::const_iterator reference = baseline.find(test.name);
+        if (reference == baseline.end())
+            recorded++;
+        else
+        {
+            stored = reference->second;
+            if (result.metrics.bad1 > stored.metrics.bad1 + SGM_BAD_PIXEL_TOLERANCE ||
+                result.metrics.bad2 > stored.metrics.bad2 + SGM_BAD_PIXEL_TOLERANCE ||
+                result.metrics.rmse > stored.metrics.rmse * (1.0 + SGM_RMSE_TOLERANCE))
+            {
+                status = "REGRESSION";
+                regressions++;
+            }
+            else
+                status = "ok";
+        }
+
+        std::snprintf(line, sizeof(line), "%-20s %-5s %-8s %5d %4d %8.2f %8.2f %10.2f %8.3f %9.2f %s\n",
+                      test.name, test.cost_type, test.precision, test.num_paths, test.subsample,
+                      result.metrics.bad1, result.metrics.bad2, result.metrics.bad2_in_range, result.metrics.rmse,
+                      result.mpix_per_s, status);
+        std::cout << line;
+
+        // The baseline keeps its recorded quality; only new configurations take the current numbers
+        std::snprintf(line, sizeof(line), "%s,%.4f,%.4f,%.4f,%.4f,%.3f\n", test.name, stored.metrics.bad1,
+                      stored.metrics.bad2, stored.metrics.bad2_in_range, stored.metrics.rmse, result.mpix_per_s);
+        csv << line;
+    }
+
+    if (recorded > 0)
+    {
+        std::ofstream stream_baseline(baseline_path.c_str());
+        stream_baseline << csv.str();
+        std::cout << ">>> Baseline written to: " << baseline_path << std::endl;
+    }
+
+    sgm_destroy_workspace(workspace);
+    delete[] disparity_output;
+
+    if (regressions > 0)
+    {
+        std::cerr << ">>> " << regressions << " configuration(s) regressed against the baseline." << std::endl;
+        return 1;
+    }
+    std::cout << ">>> Accuracy check passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "sgm_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file api_tb.c
+ * @brief C client of libsgm: version check, strided ROI frames in every pixel type, argument validation.
+ *
+ * Written in C (no HLS or C++ headers) to keep the public interface honest. The test pair is embedded
+ * at an offset inside wider buffers of uint8, uint16 and float pixels, as a camera buffer or an image
+ * crop would be, and each run must reproduce the packed float result, which is written to RESULT_PATH
+ * api_disparity.txt in the format of main_tb.
+ *
+ * Usage: api_tb [row_padding_pixels]
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#ifndef RESULT_PATH
+#define RESULT_PATH "../../../results/"
+#endif
+
+#define ROI_X 5 // Column of the test pair inside the padded buffers
+#define ROI_Y 3 // Row of the test pair inside the padded buffers
+
+static int read_pixels(const char *name, float *pixels, size_t count)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", DATA_PATH, name);
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "CRITICAL ERROR: cannot open %s\n", path);
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (fscanf(file, "%f", &pixels[i]) != 1)
+        {
+            fprintf(stderr, "CRITICAL ERROR: %s: pixel stream shorter than the requested geometry\n", path);
+            fclose(file);
+            return 0;
+        }
+    }
+    fclose(file);
+    return 1;
+}
+
+/**
+ * @brief Copies a packed float frame to (ROI_X, ROI_Y) of a buffer with @p pitch pixels per row.
+ * @return Pointer to the first ROI pixel.
+ */
+static const void *embed(const float *frame, int rows, int cols, int pitch, int pixel_type, void *buffer)
+{
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+        {
+            size_t i = (size_t)(y + ROI_Y) * pitch + (x + ROI_X);
+            float value = frame[(size_t)y * cols + x];
+            if (pixel_type == SGM_API_PIXEL_U8)
+                ((uint8_t *)buffer)[i] = (uint8_t)value;
+            else if (pixel_type == SGM_API_PIXEL_U16)
+                ((uint16_t *)buffer)[i] = (uint16_t)value;
+            else
+                ((float *)buffer)[i] = value;
+        }
+    }
+    size_t origin = (size_t)ROI_Y * pitch + ROI_X;
+    if (pixel_type == SGM_API_PIXEL_U8)
+        return (uint8_t *)buffer + origin;
+    if (pixel_type == SGM_API_PIXEL_U16)
+        return (uint16_t *)buffer + origin;
+    return (float *)buffer + origin;
+}
+
+int main(int argc, char **argv)
+{
+    int padding = (argc > 1) ? atoi(argv[1]) : 37;
+    if (padding < 0)
+        padding = 0;
+
+    uint32_t version = sgm_api_version();
+    if ((version >> 16) != SGM_API_VERSION_MAJOR)
+    {
+        fprintf(stderr, "CRITICAL ERROR: libsgm API %u.%u, header %d.%d\n", version >> 16, version & 0xffff,
+                SGM_API_VERSION_MAJOR, SGM_API_VERSION_MINOR);
+        return -1;
+    }
+
+    sgm_api_config config;
+    sgm_api_default_config(&config);
+    int rows = config.rows, cols = config.cols;
+    int pitch = ROI_X + cols + padding;
+    size_t count = (size_t)rows * cols;
+    size_t buffer_pixels = (size_t)(ROI_Y + rows) * pitch;
+
+    float *left = malloc(count * sizeof(float));
+    float *right = malloc(count * sizeof(float));
+    void *left_buffer = calloc(buffer_pixels, sizeof(float));
+    void *right_buffer = calloc(buffer_pixels, sizeof(float));
+    int32_t *packed = malloc(count * sizeof(int32_t));
+    int32_t *strided = malloc(count * sizeof(int32_t));
+    int failures = 0;
+
+    if (!read_pixels("left_pixels.txt", left, count) || !read_pixels("right_pixels.txt", right, count))
+        return -1;
+
+    printf(">>> libsgm API %u.%u: %dx%d, %d disparities, ROI at (%d, %d) of %d-pixel rows\n", version >> 16,
+           version & 0xffff, cols, rows, config.disp_range, ROI_X, ROI_Y, pitch);
+
+    int status;
+    sgm_engine *engine = sgm_create(&config, &status);
+    if (!engine)
+    {
+        fprintf(stderr, "CRITICAL ERROR: sgm_create: %s\n", sgm_api_status_string(status));
+        return -1;
+    }
+
+    if (sgm_compute(engine, left, right, 0, packed) != SGM_API_OK)
+    {
+        fprintf(stderr, "CRITICAL ERROR: sgm_compute failed\n");
+        return -1;
+    }
+
+    // The test pair holds integer intensities, so every pixel type must give the packed float map
+    static const char *const type_names[] = {"uint8", "uint16", "float"};
+    static const size_t type_bytes[] = {1, 2, 4};
+    for (int type = SGM_API_PIXEL_U8; type <= SGM_API_PIXEL_F32; type++)
+    {
+        const void *left_roi = embed(left, rows, cols, pitch, type, left_buffer);
+        const void *right_roi = embed(right, rows, cols, pitch, type, right_buffer);
+        int result = sgm_compute_pixels(engine, left_roi, right_roi, type, pitch * type_bytes[type], strided);
+        int match = (result == SGM_API_OK) && memcmp(packed, strided, count * sizeof(int32_t)) == 0;
+        printf("%-7s stride %6zu bytes: %s\n", type_names[type], pitch * type_bytes[type],
+               match ? "ok" : "MISMATCH");
+        if (!match)
+            failures++;
+    }
+
+    // Rejected inputs: short stride, misaligned stride, unknown pixel type, null buffers, unsupported geometry
+    if (sgm_compute(engine, left, right, cols * sizeof(float) - 4, packed) != SGM_API_ERROR_ARGUMENT ||
+        sgm_compute(engine, left, right, cols * sizeof(float) + 2, packed) != SGM_API_ERROR_ARGUMENT ||
+        sgm_compute_pixels(engine, left, right, 7, 0, packed) != SGM_API_ERROR_ARGUMENT ||
+        sgm_compute(engine, 0, right, 0, packed) != SGM_API_ERROR_ARGUMENT)
+    {
+        fprintf(stderr, ">>> Invalid arguments were accepted.\n");
+        failures++;
+    }
+    sgm_api_config oversized = config;
+    int32_t max_rows;
+    sgm_api_limits(&max_rows, 0, 0);
+    oversized.rows = max_rows + 1;
+    if (sgm_create(&oversized, &status) || status != SGM_API_ERROR_CONFIG)
+    {
+        fprintf(stderr, ">>> Oversized configuration was accepted.\n");
+        failures++;
+    }
+    sgm_destroy(engine);
+
+    FILE *output = fopen(RESULT_PATH "api_disparity.txt", "w");
+    if (output)
+    {
+        for (size_t i = 0; i < count; i++)
+            fprintf(output, "%d\n", packed[i]);
+        fclose(output);
+    }
+
+    free(left);
+    free(right);
+    free(left_buffer);
+    free(right_buffer);
+    free(packed);
+    free(strided);
+
+    if (failures > 0)
+        return 1;
+    printf(">>> C API checks passed (strided ROI maps identical to the packed map).\n");
+    return 0;
+}
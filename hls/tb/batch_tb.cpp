@@ -0,0 +1,274 @@
+#include "sgm_hls.h"
+#include "dataset.h"
+#include "disparity_metrics.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file batch_tb.cpp
+ * @brief Dataset batch runner: evaluates every stereo pair below a Middlebury / KITTI directory tree.
+ *
+ * Loader threads decode and resample pairs ahead of the compute workers (bounded prefetch queue), so
+ * PNG/PFM decoding overlaps matching. Each worker owns its own sgm_workspace_t and processes whole
+ * pairs in parallel. Metrics and timing per pair are written to CSV in dataset order.
+ *
+ * Usage: batch_tb <dataset_dir> [output.csv] [workers] [loaders]
+ */
+
+#ifndef RESULT_PATH
+#define RESULT_PATH "../../../results/"
+#endif
+
+#define SGM_PREFETCH_PER_WORKER 2 // Loaded pairs buffered per worker before loaders block
+
+/**
+ * @brief Pair decoded by a loader thread, waiting for a compute worker.
+ */
+struct prefetched_pair
+{
+    size_t index;
+    bool ok;
+    std::string error;
+    double load_ms;
+    sgm_loaded_pair data;
+};
+
+/**
+ * @brief Per-pair outcome, stored by index so the CSV keeps dataset order.
+ */
+struct pair_result
+{
+    bool ok;
+    std::string error;
+    int rows, cols;
+    double load_ms;
+    double compute_ms;
+    bool has_ground_truth;
+    sgm_disparity_metrics metrics;
+};
+
+/**
+ * @brief Bounded multi-producer / multi-consumer handoff between loaders and workers.
+ */
+class prefetch_queue
+{
+public:
+    explicit prefetch_queue(size_t queue_capacity) : capacity(queue_capacity), producers_left(0) {}
+
+    void set_producers(int count) { producers_left = count; }
+
+    void push(prefetched_pair *item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return items.size() < capacity; });
+        items.push_back(item);
+        not_empty.notify_one();
+    }
+
+    void producer_done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        producers_left--;
+        not_empty.notify_all();
+    }
+
+    /** @return 0 once every producer finished and the queue is drained. */
+    prefetched_pair *pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !items.empty() || producers_left == 0; });
+        if (items.empty())
+            return 0;
+        prefetched_pair *item = items.front();
+        items.pop_front();
+        not_full.notify_one();
+        return item;
+    }
+
+private:
+    size_t capacity;
+    int producers_left;
+    std::deque<prefetched_pair *> items;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <dataset_dir> [output.csv] [workers] [loaders]" << std::endl;
+        return -1;
+    }
+
+    std::string dataset_root = argv[1];
+    std::string path_csv = (argc > 2) ? argv[2] : std::string(RESULT_PATH) + "batch_results.csv";
+    unsigned hardware_threads = std::thread::hardware_concurrency();
+    int workers = (argc > 3) ? std::atoi(argv[3]) : (int)(hardware_threads > 0 ? hardware_threads : 1);
+    int loaders = (argc > 4) ? std::atoi(argv[4]) : 2;
+    if (workers < 1)
+        workers = 1;
+    if (loaders < 1)
+        loaders = 1;
+
+    std::string error;
+    std::vector<sgm_stereo_pair> pairs;
+    if (!sgm_scan_dataset(dataset_root, pairs, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    std::cout << ">>> SGM Batch Runner: " << pairs.size() << " pair(s), " << workers << " worker(s), " << loaders
+              << " loader(s), processing grid <= " << WIDTH << "x" << HEIGHT << ", " << MAX_DISP << " disparities"
+              << std::endl;
+
+    std::vector<pair_result> results(pairs.size());
+    prefetch_queue queue((size_t)workers * SGM_PREFETCH_PER_WORKER);
+    queue.set_producers(loaders);
+    std::mutex claim_mutex;
+    size_t next_pair = 0;
+
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+    // Loaders: claim the next pair, decode and resample it, hand it to the workers
+    std::vector<std::thread> loader_threads;
+    for (int l = 0; l < loaders; l++)
+    {
+        loader_threads.push_back(std::thread([&]() {
+            for (;;)
+            {
+                size_t index;
+                {
+                    std::lock_guard<std::mutex> lock(claim_mutex);
+                    if (next_pair >= pairs.size())
+                        break;
+                    index = next_pair++;
+                }
+
+                prefetched_pair *item = new prefetched_pair;
+                item->index = index;
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                item->ok = sgm_load_pair(pairs[index], WIDTH, HEIGHT, item->data, item->error);
+                item->load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                queue.push(item);
+            }
+            queue.producer_done();
+        }));
+    }
+
+    // Workers: one workspace each, run the engine and score against ground truth
+    std::vector<std::thread> worker_threads;
+    for (int w = 0; w < workers; w++)
+    {
+        worker_threads.push_back(std::thread([&]() {
+            sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+            std::vector<int> disparity(HEIGHT * WIDTH);
+
+            while (prefetched_pair *item = queue.pop())
+            {
+                pair_result &result = results[item->index];
+                result.ok = item->ok;
+                result.error = item->error;
+                result.load_ms = item->load_ms;
+                result.compute_ms = 0.0;
+                result.has_ground_truth = false;
+                result.rows = item->data.rows;
+                result.cols = item->data.cols;
+                if (result.ok && !workspace)
+                {
+                    // The worker still drains its share of the queue, so the loaders never stall
+                    result.ok = false;
+                    result.error = "cannot allocate the worker workspace";
+                }
+
+                if (result.ok)
+                {
+                    sgm_config_t config = sgm_default_config();
+                    config.rows = item->data.rows;
+                    config.cols = item->data.cols;
+
+                    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                    sgm_compute(config, &item->data.left.pixels[0], &item->data.right.pixels[0], &disparity[0], *workspace);
+                    result.compute_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+                    result.has_ground_truth = !item->data.ground_truth.pixels.empty();
+                    if (result.has_ground_truth)
+                        result.metrics = sgm_evaluate_disparity(&disparity[0], item->data.ground_truth, config.disp_range);
+                }
+                delete item;
+            }
+            sgm_destroy_workspace(workspace);
+        }));
+    }
+
+    for (size_t i = 0; i < loader_threads.size(); i++)
+        loader_threads[i].join();
+    for (size_t i = 0; i < worker_threads.size(); i++)
+        worker_threads[i].join();
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    // Persist per-pair metrics and timing in dataset order
+    std::ofstream stream_csv(path_csv.c_str());
+    if (!stream_csv.is_open())
+    {
+        std::cerr << "CRITICAL ERROR: cannot write " << path_csv << std::endl;
+        return -1;
+    }
+    stream_csv << "pair,cols,rows,disp_range,load_ms,compute_ms,mpix_per_s,valid_pixels,bad1,bad2,bad2_in_range,rmse,status\n";
+
+    int failures = 0, evaluated = 0;
+    double sum_bad2 = 0.0, sum_rmse = 0.0, total_pixels = 0.0, total_compute_s = 0.0;
+    char line[512];
+    for (size_t i = 0; i < pairs.size(); i++)
+    {
+        const pair_result &r = results[i];
+        if (!r.ok)
+        {
+            failures++;
+            std::snprintf(line, sizeof(line), "%s,,,,%.3f,,,,,,,,\"%s\"\n", pairs[i].name.c_str(), r.load_ms, r.error.c_str());
+            stream_csv << line;
+            continue;
+        }
+
+        double mpix = (r.compute_ms > 0.0) ? (double)r.rows * r.cols / (r.compute_ms * 1e3) : 0.0;
+        total_pixels += (double)r.rows * r.cols;
+        total_compute_s += r.compute_ms / 1e3;
+        if (r.has_ground_truth)
+        {
+            evaluated++;
+            sum_bad2 += r.metrics.bad2;
+            sum_rmse += r.metrics.rmse;
+            std::snprintf(line, sizeof(line), "%s,%d,%d,%d,%.3f,%.3f,%.3f,%ld,%.4f,%.4f,%.4f,%.4f,ok\n",
+                          pairs[i].name.c_str(), r.cols, r.rows, MAX_DISP, r.load_ms, r.compute_ms, mpix,
+                          r.metrics.valid_pixels, r.metrics.bad1, r.metrics.bad2, r.metrics.bad2_in_range, r.metrics.rmse);
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "%s,%d,%d,%d,%.3f,%.3f,%.3f,0,,,,,no_ground_truth\n",
+                          pairs[i].name.c_str(), r.cols, r.rows, MAX_DISP, r.load_ms, r.compute_ms, mpix);
+        }
+        stream_csv << line;
+    }
+
+    std::printf(">>> Processed %d pair(s) in %.2f s (%.2f Mpix/s aggregate, %.2f Mpix/s per worker), %d failed\n",
+                (int)pairs.size() - failures, wall_s, total_pixels / wall_s / 1e6,
+                (total_compute_s > 0.0) ? total_pixels / total_compute_s / 1e6 : 0.0, failures);
+    if (evaluated > 0)
+        std::printf(">>> Mean over %d pair(s) with ground truth: bad2 %.2f %%, RMSE %.3f px\n",
+                    evaluated, sum_bad2 / evaluated, sum_rmse / evaluated);
+    std::cout << ">>> Per-pair results saved to: " << path_csv << std::endl;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+#include "sgm_hls.h"
+#include "sgm_profile.h"
+#include "roofline.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/**
+ * @file bench_tb.cpp
+ * @brief Benchmark testbench: repeated C-model runs with per-stage profile and roofline report.
+ *
+ * Build together with sgm_hls.cpp and -DSGM_PROFILE (optionally -O3 -march=native for host numbers).
+ */
+
+#ifndef SGM_PROFILE
+#error "bench_tb.cpp requires -DSGM_PROFILE so that the pipeline stages are instrumented"
+#endif
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#ifndef SGM_BENCH_ITERATIONS
+#define SGM_BENCH_ITERATIONS 10
+#endif
+
+int main()
+{
+    float *image_left_pixels = new float[HEIGHT * WIDTH];
+    float *image_right_pixels = new float[HEIGHT * WIDTH];
+    int *disparity_output = new int[HEIGHT * WIDTH];
+
+    std::string path_left_input = std::string(DATA_PATH) + "left_pixels.txt";
+    std::string path_right_input = std::string(DATA_PATH) + "right_pixels.txt";
+
+    std::ifstream stream_left(path_left_input);
+    std::ifstream stream_right(path_right_input);
+
+    if (!stream_left.is_open() || !stream_right.is_open())
+    {
+        std::cerr << "CRITICAL ERROR: Input dataset not found!" << std::endl;
+        std::cerr << "Missing sequence at: " << path_left_input << std::endl;
+        return -1;
+    }
+
+    for (int i = 0; i < HEIGHT * WIDTH; i++)
+    {
+        stream_left >> image_left_pixels[i];
+        stream_right >> image_right_pixels[i];
+    }
+
+    std::cout << ">>> Benchmarking SGM C-Model (" << WIDTH << "x" << HEIGHT << ", " << MAX_DISP
+              << " disparities, " << SGM_BENCH_ITERATIONS << " iterations)..." << std::endl;
+
+    // Warm-up run populates caches and page tables, then is excluded from the statistics
+    sgm_hls(image_left_pixels, image_right_pixels, disparity_output);
+    sgm_profiler::instance().reset();
+
+    for (int iteration = 0; iteration < SGM_BENCH_ITERATIONS; iteration++)
+        sgm_hls(image_left_pixels, image_right_pixels, disparity_output);
+
+    std::cout << ">>> Stage Profile:" << std::endl;
+    sgm_profiler::instance().report(std::cout);
+
+    std::cout << ">>> Probing machine peak (STREAM-like bandwidth, add/compare throughput)..." << std::endl;
+    sgm_machine_peak peak = sgm_probe_machine_peak();
+
+    std::cout << ">>> Roofline:" << std::endl;
+    sgm_roofline_report(std::cout, sgm_profiler::instance().snapshot(), peak);
+
+    delete[] image_left_pixels;
+    delete[] image_right_pixels;
+    delete[] disparity_output;
+
+    return 0;
+}
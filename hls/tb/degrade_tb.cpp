@@ -0,0 +1,271 @@
+#include "sgm_hls.h"
+#include "image_io.h"
+#include "quality_governor.h"
+#include "stream_mux.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file degrade_tb.cpp
+ * @brief Deadline-aware graceful degradation on the test pair.
+ *
+ * 1. Prints the quality ladder of the default 4-path and of an 8-path configuration. Level 0 must run
+ *    bit-identical to sgm_hls().
+ * 2. Sweeps the per-frame budget from generous to impossible. It reports the level the governor picks,
+ *    the achieved time and the share of pixels within 1 disparity of the full-quality map. The chosen
+ *    level may only get coarser as the budget shrinks.
+ * 3. Runs every level a few times, then compares its prediction with the median of the next runs. The
+ *    error must stay within SGM_DEGRADE_PREDICTION_TOLERANCE at every level (a level gets a second check if
+ *    a load burst spoils the first). The estimate of the stage model
+ *    alone (before the level's own correction) is printed next to it.
+ * 4. Overloads a degrading stream of sgm_stream_mux with a burst, checks that it steps down and reports
+ *    the level of every frame, and checks that a normal stream stays at level 0.
+ *
+ * Usage: degrade_tb [frames_per_budget]
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#define SGM_DEGRADE_WARMUP_FRAMES 5        // Recorded runs per level before its prediction is checked
+#define SGM_DEGRADE_CHECK_FRAMES 9         // Runs per level whose median is compared with the prediction
+#define SGM_DEGRADE_PREDICTION_TOLERANCE 0.35 // Allowed |predicted - measured| / measured per level
+#define SGM_DEGRADE_CHECK_ATTEMPTS 2       // Checks per level before a miss counts (absorbs a load burst)
+
+static void print_ladder(const char *title, const sgm_quality_governor &governor)
+{
+    std::cout << ">>> Quality ladder of the " << title << " configuration:" << std::endl;
+    for (int level = 0; level < governor.levels(); level++)
+    {
+        const sgm_config_t &config = governor.level(level);
+        std::printf("    level %d: %d path(s), subsample %d, %d disparities, predicted %.2f ms\n", level,
+                    config.num_paths, config.subsample, config.disp_range, governor.predict_ns(level) / 1e6);
+    }
+}
+
+/**
+ * @brief Records SGM_DEGRADE_WARMUP_FRAMES runs of @p level, then returns the relative error of its
+ * prediction against the median of SGM_DEGRADE_CHECK_FRAMES further runs.
+ */
+static double prediction_error(sgm_quality_governor &governor, int level, const float *left, const float *right,
+                               int *disparity, sgm_workspace_t &workspace, int64_t &predicted_ns, int64_t &median_ns)
+{
+    sgm_stage_timing timing;
+    for (int f = 0; f < SGM_DEGRADE_WARMUP_FRAMES; f++)
+    {
+        sgm_compute_timed(governor.level(level), left, right, disparity, workspace, timing);
+        governor.record(level, timing);
+    }
+    predicted_ns = governor.predict_ns(level);
+    std::vector<int64_t> measured(SGM_DEGRADE_CHECK_FRAMES);
+    for (int f = 0; f < SGM_DEGRADE_CHECK_FRAMES; f++)
+    {
+        sgm_compute_timed(governor.level(level), left, right, disparity, workspace, timing);
+        measured[f] = timing.cost_ns + timing.aggregate_ns + timing.wta_ns;
+    }
+    std::sort(measured.begin(), measured.end());
+    median_ns = measured[SGM_DEGRADE_CHECK_FRAMES / 2];
+    return std::fabs((double)(predicted_ns - median_ns)) / median_ns;
+}
+
+static double within_one(const int *disparity, const int *reference)
+{
+    int close = 0;
+    for (int i = 0; i < HEIGHT * WIDTH; i++)
+        close += std::abs(disparity[i] - reference[i]) <= 1;
+    return 100.0 * close / (HEIGHT * WIDTH);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = (argc > 1) ? std::atoi(argv[1]) : 4;
+    if (frames < 1)
+        frames = 1;
+
+    std::string error;
+    sgm_image left, right;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    std::vector<int> reference(HEIGHT * WIDTH), disparity(HEIGHT * WIDTH);
+    sgm_hls(&left.pixels[0], &right.pixels[0], &reference[0]);
+
+    sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+    if (!workspace)
+    {
+        std::cerr << "CRITICAL ERROR: cannot allocate the workspace" << std::endl;
+        return -1;
+    }
+    int failures = 0;
+
+    // 1. Ladders; calibration frames at level 0 (no deadline)
+    sgm_quality_governor governor;
+    if (!governor.configure(sgm_default_config(), error) || !governor.reserve(*workspace, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    for (int f = 0; f < 2; f++)
+    {
+        if (governor.compute(INT64_MAX, &left.pixels[0], &right.pixels[0], &disparity[0], *workspace) != 0 ||
+            disparity != reference)
+        {
+            std::cerr << "CRITICAL ERROR: level 0 differs from sgm_hls()" << std::endl;
+            failures++;
+        }
+    }
+    print_ladder("default", governor);
+
+    // The stage costs measured on the default configuration carry over to the 8-path ladder
+    sgm_config_t eight_path = sgm_default_config();
+    eight_path.num_paths = SGM_TWO_PASS_PATHS;
+    eight_path.compress_step = 4;
+    if (!governor.configure(eight_path, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    print_ladder("8-path", governor);
+    governor.configure(sgm_default_config(), error);
+    for (int level = 1; level < governor.levels(); level++)
+    {
+        if (governor.predict_ns(level) >= governor.predict_ns(level - 1))
+        {
+            std::cerr << "CRITICAL ERROR: level " << level << " is not predicted cheaper than level " << level - 1
+                      << std::endl;
+            failures++;
+        }
+    }
+
+    // 2. Budget sweep
+    int64_t full_ns = governor.predict_ns(0);
+    static const double budget_fractions[] = {2.0, 0.8, 0.5, 0.3, 0.15, 0.0};
+    std::printf("%12s %6s %12s %10s %12s\n", "budget ms", "level", "compute ms", "in budget", "within 1 px");
+    int previous_level = 0;
+    for (size_t b = 0; b < sizeof(budget_fractions) / sizeof(budget_fractions[0]); b++)
+    {
+        int64_t budget_ns = (int64_t)(full_ns * budget_fractions[b]);
+        int level = 0, in_budget = 0;
+        double total_ms = 0.0;
+        for (int f = 0; f < frames; f++)
+        {
+            sgm_stage_timing timing;
+            level = governor.choose(budget_ns);
+            sgm_compute_timed(governor.level(level), &left.pixels[0], &right.pixels[0], &disparity[0], *workspace,
+                              timing);
+            governor.record(level, timing);
+            int64_t elapsed = timing.cost_ns + timing.aggregate_ns + timing.wta_ns;
+            total_ms += elapsed / 1e6;
+            in_budget += elapsed <= budget_ns;
+        }
+        std::printf("%12.2f %6d %12.2f %9d/%d %11.1f%%\n", budget_ns / 1e6, level, total_ms / frames, in_budget,
+                    frames, within_one(&disparity[0], &reference[0]));
+        if (level < previous_level)
+        {
+            std::cerr << "CRITICAL ERROR: a smaller budget chose a better level" << std::endl;
+            failures++;
+        }
+        previous_level = level;
+    }
+    if (previous_level != governor.levels() - 1)
+    {
+        std::cerr << "CRITICAL ERROR: a zero budget did not choose the cheapest level" << std::endl;
+        failures++;
+    }
+
+    // 3. Prediction error per level
+    std::printf("%6s %14s %12s %12s %8s\n", "level", "first est. ms", "predict ms", "measured ms", "error");
+    for (int level = 0; level < governor.levels(); level++)
+    {
+        int64_t first_estimate_ns = governor.predict_ns(level), predicted_ns = 0, median_ns = 0;
+        double error = 0.0;
+        for (int attempt = 0; attempt < SGM_DEGRADE_CHECK_ATTEMPTS; attempt++)
+        {
+            error = prediction_error(governor, level, &left.pixels[0], &right.pixels[0], &disparity[0], *workspace,
+                                     predicted_ns, median_ns);
+            if (error <= SGM_DEGRADE_PREDICTION_TOLERANCE)
+                break;
+        }
+        std::printf("%6d %14.2f %12.2f %12.2f %7.1f%%\n", level, first_estimate_ns / 1e6, predicted_ns / 1e6,
+                    median_ns / 1e6, 100.0 * error);
+        if (error > SGM_DEGRADE_PREDICTION_TOLERANCE)
+        {
+            std::cerr << "CRITICAL ERROR: level " << level << " is mispredicted by " << 100.0 * error << "%"
+                      << std::endl;
+            failures++;
+        }
+    }
+    sgm_destroy_workspace(workspace);
+
+    // 4. Overloaded stream: a burst with a deadline below one full-quality frame
+    sgm_stream_mux mux;
+    std::mutex result_mutex;
+    std::vector<int> levels[2];
+    std::vector<std::vector<int> > outputs(2 * frames, std::vector<int>(HEIGHT * WIDTH));
+    for (int s = 0; s < 2; s++)
+    {
+        sgm_stream_settings settings;
+        settings.name = s == 0 ? "degrading" : "fixed";
+        settings.config = sgm_default_config();
+        settings.deadline_ns = full_ns / 2;
+        settings.weight = 1;
+        settings.queue_depth = frames;
+        settings.degrade = (s == 0);
+        std::vector<int> &stream_levels = levels[s];
+        if (mux.add_stream(settings, [&stream_levels, &result_mutex](const sgm_frame_result &result) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                stream_levels.push_back(result.quality_level);
+            }, error) != s)
+        {
+            std::cerr << "CRITICAL ERROR: " << error << std::endl;
+            return -1;
+        }
+        for (int f = 0; f < frames; f++)
+            mux.submit(s, f, &left.pixels[0], &right.pixels[0], &outputs[s * frames + f][0], error);
+    }
+    if (!mux.start(1, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    mux.drain();
+    mux.stop();
+
+    for (int s = 0; s < 2; s++)
+    {
+        sgm_stream_stats stats;
+        mux.statistics(s, stats);
+        std::printf(">>> Stream %s: %llu frame(s), %llu late, levels:", s == 0 ? "degrading" : "fixed",
+                    (unsigned long long)stats.frames, (unsigned long long)stats.late);
+        for (size_t f = 0; f < levels[s].size(); f++)
+            std::printf(" %d", levels[s][f]);
+        std::printf("\n");
+    }
+    int deepest = 0;
+    for (size_t f = 0; f < levels[0].size(); f++)
+        deepest = levels[0][f] > deepest ? levels[0][f] : deepest;
+    bool fixed_full = levels[1].size() == (size_t)frames;
+    for (size_t f = 0; f < levels[1].size(); f++)
+        fixed_full = fixed_full && levels[1][f] == 0 && outputs[frames + f] == reference;
+    if (levels[0].size() != (size_t)frames || deepest == 0 || !fixed_full)
+    {
+        std::cerr << "CRITICAL ERROR: the overloaded stream did not degrade, or the fixed stream did" << std::endl;
+        failures++;
+    }
+
+    if (failures > 0)
+        return 1;
+    std::cout << ">>> Graceful degradation verified." << std::endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "sgm_hls.h"
+#include "image_io.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @file footprint_tb.cpp
+ * @brief Measured host memory of each aggregation mode on the test pair.
+ *
+ * Every mode runs in a forked process of its own: it creates a workspace for the configuration
+ * (sgm_create_workspace), computes one frame and reports the growth of its peak resident set (getrusage
+ * ru_maxrss) over the start of the process, next to the bytes the workspace allocated. Checks:
+ * - no mode peaks more than SGM_FOOTPRINT_SLACK_KB above its workspace bytes (nothing else is allocated)
+ * - the memory-bounded 8-path mode peaks below a quarter of the stored 4-path mode and below half of the
+ *   float 8-path mode
+ * - the compressed 8-path mode (per-pixel minimum + 8-bit deltas) peaks below the float 8-path mode
+ *
+ * Usage: footprint_tb
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#define SGM_FOOTPRINT_SLACK_KB 2048 // Stack, allocator and page-table overhead allowed on top of the workspace
+
+struct footprint_mode
+{
+    const char *name;
+    int num_paths;
+    int compress_step;
+    int recompute_cost;
+    int single_sweep;
+    int memory_bounded;
+};
+
+static const footprint_mode footprint_modes[] = {
+    {"4path", 4, 0, 0, 0, 0},
+    {"4path_recompute", 4, 0, 1, 0, 0},
+    {"4path_single_sweep", 4, 0, 0, 1, 0},
+    {"8path", 8, 0, 0, 0, 0},
+    {"8path_compressed", 8, 4, 0, 0, 0},
+    {"8path_bounded", 8, 0, 0, 0, 1},
+};
+
+struct footprint_result
+{
+    long peak_kb;            // Peak resident set growth
+    unsigned long workspace; // sgm_workspace_bytes
+    int ok;
+};
+
+static long peak_rss_kb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief Child process: one frame of @p mode, result written to @p fd.
+ */
+static int run_mode(const footprint_mode &mode, const sgm_image &left, const sgm_image &right, int fd)
+{
+    footprint_result result = footprint_result();
+    long start_kb = peak_rss_kb();
+
+    sgm_config_t config = sgm_default_config();
+    config.num_paths = mode.num_paths;
+    config.compress_step = mode.compress_step;
+    config.recompute_cost = mode.recompute_cost;
+    config.single_sweep = mode.single_sweep;
+    config.memory_bounded = mode.memory_bounded;
+    sgm_workspace_t *workspace = sgm_create_workspace(config);
+    std::vector<int> disparity(HEIGHT * WIDTH);
+    if (sgm_check_config(config) == 0 && workspace)
+    {
+        sgm_compute(config, &left.pixels[0], &right.pixels[0], &disparity[0], *workspace);
+        result.workspace = sgm_workspace_bytes(*workspace);
+        result.peak_kb = peak_rss_kb() - start_kb;
+        result.ok = 1;
+    }
+    sgm_destroy_workspace(workspace);
+    return write(fd, &result, sizeof(result)) == (ssize_t)sizeof(result) ? 0 : 1;
+}
+
+int main()
+{
+    std::string error;
+    sgm_image left, right;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    const int mode_count = sizeof(footprint_modes) / sizeof(footprint_modes[0]);
+    std::vector<footprint_result> results(mode_count);
+    int failures = 0;
+
+    std::cout << ">>> SGM Memory Footprint (" << WIDTH << "x" << HEIGHT << ", " << MAX_DISP << " disparities)"
+              << std::endl;
+    std::printf("%-20s %14s %14s\n", "mode", "workspace_MB", "peak_rss_MB");
+    for (int m = 0; m < mode_count; m++)
+    {
+        int channel[2];
+        if (pipe(channel) != 0)
+        {
+            std::cerr << "CRITICAL ERROR: pipe failed" << std::endl;
+            return -1;
+        }
+        pid_t child = fork();
+        if (child < 0)
+        {
+            std::cerr << "CRITICAL ERROR: fork failed" << std::endl;
+            return -1;
+        }
+        if (child == 0)
+        {
+            close(channel[0]);
+            _exit(run_mode(footprint_modes[m], left, right, channel[1]));
+        }
+        close(channel[1]);
+        footprint_result &result = results[m];
+        int status = 0;
+        bool received = read(channel[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+        close(channel[0]);
+        waitpid(child, &status, 0);
+        if (!received || !result.ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            std::cerr << "CRITICAL ERROR: mode " << footprint_modes[m].name << " did not run" << std::endl;
+            failures++;
+            continue;
+        }
+
+        std::printf("%-20s %14.2f %14.2f\n", footprint_modes[m].name, result.workspace / 1048576.0,
+                    result.peak_kb / 1024.0);
+        if (result.peak_kb > (long)(result.workspace / 1024) + SGM_FOOTPRINT_SLACK_KB)
+        {
+            std::cerr << "CRITICAL ERROR: mode " << footprint_modes[m].name
+                      << " peaks above its workspace allocation" << std::endl;
+            failures++;
+        }
+    }
+
+    // Modes by index in footprint_modes
+    const footprint_result &stored = results[0], &summed = results[3], &compressed = results[4],
+                           &bounded = results[5];
+    if (failures == 0 && (bounded.peak_kb * 4 >= stored.peak_kb || bounded.peak_kb * 2 >= summed.peak_kb))
+    {
+        std::cerr << "CRITICAL ERROR: the memory-bounded mode does not bound the footprint" << std::endl;
+        failures++;
+    }
+    if (failures == 0 && compressed.peak_kb >= summed.peak_kb)
+    {
+        std::cerr << "CRITICAL ERROR: the compressed forward sum does not reduce the footprint" << std::endl;
+        failures++;
+    }
+
+    if (failures > 0)
+        return 1;
+    std::cout << ">>> Memory footprint verified." << std::endl;
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include "sgm_hls.h"
+#include "sgm_profile.h"
+#include "image_io.h"
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -17,6 +19,11 @@
 #define RESULT_PATH "../../../results/"
 #endif
 
+// Disparity output encoding: "txt" (notebook/RTL comparison), "raw8", "raw16", "pfm" or "png16"
+#ifndef OUTPUT_FORMAT
+#define OUTPUT_FORMAT "txt"
+#endif
+
 int main()
 {
     // Allocate image buffers on the heap to avoid stack overflow during C-Simulation (Large Arrays)
@@ -27,7 +34,14 @@ int main()
     // Construct absolute/relative file paths for dataset and result logging
     std::string path_left_input = std::string(DATA_PATH) + "left_pixels.txt";
     std::string path_right_input = std::string(DATA_PATH) + "right_pixels.txt";
-    std::string path_result_out = std::string(RESULT_PATH) + "hls_disparity.txt";
+    sgm_disparity_format output_format;
+    if (!sgm_parse_disparity_format(OUTPUT_FORMAT, output_format))
+    {
+        std::cerr << "CRITICAL ERROR: Unknown OUTPUT_FORMAT " << OUTPUT_FORMAT << std::endl;
+        return -1;
+    }
+    static const char *const output_suffix[] = {".txt", "_u8.raw", "_u16.raw", ".pfm", "_16bit.png"};
+    std::string path_result_out = std::string(RESULT_PATH) + "hls_disparity" + output_suffix[output_format];
 
     // Initialize file input streams
     std::ifstream stream_left(path_left_input);
@@ -52,15 +66,22 @@ int main()
     // Execute Top-Level IP Core Function (Under Test)
     sgm_hls(image_left_pixels, image_right_pixels, disparity_output);
 
-    // Persist resulting disparity map to text for Python/RTL verification
-    std::ofstream stream_out(path_result_out);
-    for (int i = 0; i < HEIGHT * WIDTH; i++)
+    // Persist resulting disparity map (single buffered write) for Python/RTL verification
+    std::string error;
+    if (!sgm_write_disparity(path_result_out, disparity_output, WIDTH, HEIGHT, output_format, 1, error))
     {
-        stream_out << disparity_output[i] << "\n";
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
     }
 
     std::cout << ">>> Simulation Complete. Hardware results saved to: " << path_result_out << std::endl;
 
+#ifdef SGM_PROFILE
+    // Per-stage timing and hardware counters (build with -DSGM_PROFILE)
+    std::cout << ">>> Stage Profile:" << std::endl;
+    sgm_profiler::instance().report(std::cout);
+#endif
+
     // Release heap-allocated resources
     delete[] image_left_pixels;
     delete[] image_right_pixels;
@@ -0,0 +1,77 @@
+#include "sgm_hls.h"
+#include "image_io.h"
+#include "row_pipeline.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file row_pipeline_tb.cpp
+ * @brief Frame latency of the row-granular two-thread pipeline against sequential sgm_compute().
+ *
+ * Usage: row_pipeline_tb [iterations]
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 10;
+    if (iterations < 1)
+        iterations = 1;
+
+    std::string error;
+    sgm_image left, right;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+    std::vector<int> reference(HEIGHT * WIDTH), pipelined(HEIGHT * WIDTH);
+    static const int path_counts[] = {1, 2, 4};
+    int mismatches = 0;
+
+    std::cout << ">>> SGM Row Pipeline (" << WIDTH << "x" << HEIGHT << ", " << MAX_DISP << " disparities, "
+              << iterations << " iteration(s))" << std::endl;
+    std::printf("%-6s %14s %14s %8s %s\n", "paths", "sequential_ms", "pipelined_ms", "speedup", "status");
+
+    for (size_t c = 0; c < sizeof(path_counts) / sizeof(path_counts[0]); c++)
+    {
+        sgm_config_t config = sgm_default_config();
+        config.num_paths = path_counts[c];
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            sgm_compute(config, &left.pixels[0], &right.pixels[0], &reference[0], *workspace);
+        double sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            sgm_compute_row_pipelined(config, &left.pixels[0], &right.pixels[0], &pipelined[0], *workspace);
+        double pipelined_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        bool match = (pipelined == reference);
+        if (!match)
+            mismatches++;
+        std::printf("%-6d %14.3f %14.3f %7.2fx %s\n", config.num_paths, sequential_ms / iterations,
+                    pipelined_ms / iterations, sequential_ms / pipelined_ms, match ? "ok" : "MISMATCH");
+    }
+
+    sgm_destroy_workspace(workspace);
+
+    if (mismatches > 0)
+    {
+        std::cerr << ">>> " << mismatches << " configuration(s) differ from sgm_compute()." << std::endl;
+        return 1;
+    }
+    std::cout << ">>> Row pipeline matches sgm_compute()." << std::endl;
+    return 0;
+}
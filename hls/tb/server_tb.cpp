@@ -0,0 +1,346 @@
+#include "sgm_hls.h"
+#include "disparity_server.h"
+#include "image_io.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @file server_tb.cpp
+ * @brief Disparity daemon round trip: several client processes share one in-process server.
+ *
+ * The clients are forked first and retry their connection until the server listens, so no process is
+ * forked while worker threads run. Each client attaches one shared buffer with `depth` request slots,
+ * keeps them all in flight and checks every returned map against a reference run. One client also sends
+ * a request outside its buffer and expects SGM_SERVER_ERROR_REQUEST, then a request carrying two
+ * descriptors, which must be refused with both descriptors closed by the server. It then attaches a memfd
+ * shorter than the size it claims, which must be refused with SGM_SERVER_ERROR_ATTACH, and floods the
+ * server with requests without reading a reply, which must get the connection closed.
+ *
+ * Usage: server_tb [clients] [frames_per_client] [workers] [max_batch]
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#ifndef SGM_SERVER_TB_SOCKET
+#define SGM_SERVER_TB_SOCKET "/tmp/sgm_server_tb.sock"
+#endif
+
+#define SGM_SERVER_TB_DEPTH 2                // Requests in flight per client
+#define SGM_SERVER_TB_STALL_REQUESTS 1000000 // Upper bound on requests a non-reading client sends
+
+static size_t align_up(size_t bytes)
+{
+    return (bytes + SGM_SERVER_ALIGN - 1) / SGM_SERVER_ALIGN * SGM_SERVER_ALIGN;
+}
+
+/**
+ * @brief Raw connection to the test server, bypassing sgm_disparity_client; -1 on failure.
+ */
+static int raw_connect()
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, SGM_SERVER_TB_SOCKET, sizeof(address.sun_path) - 1);
+    int socket_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (socket_fd >= 0 && connect(socket_fd, (sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    return socket_fd;
+}
+
+static sgm_server_request raw_request(uint32_t type)
+{
+    sgm_server_request request;
+    std::memset(&request, 0, sizeof(request));
+    request.magic = SGM_SERVER_MAGIC;
+    request.version = SGM_SERVER_VERSION;
+    request.type = type;
+    return request;
+}
+
+/**
+ * @brief Sends @p request with the @p count descriptors of @p fds attached.
+ */
+static bool send_with_descriptors(int socket_fd, sgm_server_request &request, const int *fds, int count)
+{
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    std::memset(control, 0, sizeof(control));
+    iovec vector = {&request, sizeof(request)};
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = CMSG_SPACE(count * sizeof(int));
+    cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(count * sizeof(int));
+    std::memcpy(CMSG_DATA(header), fds, count * sizeof(int));
+    return sendmsg(socket_fd, &message, MSG_NOSIGNAL) == (ssize_t)sizeof(request);
+}
+
+/**
+ * @brief Sends a COMPUTE request with two copies of the write end of a pipe over a raw connection.
+ * @return True if the server refused it and closed both copies (the read end then reports end of file).
+ */
+static bool extra_descriptors_refused()
+{
+    int socket_fd = raw_connect();
+    int pipe_fds[2];
+    if (socket_fd < 0 || pipe(pipe_fds) != 0)
+        return false;
+
+    sgm_server_request request = raw_request(SGM_SERVER_COMPUTE);
+    int fds[2] = {pipe_fds[1], pipe_fds[1]};
+    bool sent = send_with_descriptors(socket_fd, request, fds, 2);
+    close(pipe_fds[1]);
+
+    sgm_server_reply reply;
+    bool refused = sent && recv(socket_fd, &reply, sizeof(reply), 0) == (ssize_t)sizeof(reply) &&
+                   reply.status == SGM_SERVER_ERROR_REQUEST;
+    pollfd closed = {pipe_fds[0], POLLIN, 0};
+    char byte;
+    bool released = poll(&closed, 1, 1000) == 1 && read(pipe_fds[0], &byte, 1) == 0;
+    close(pipe_fds[0]);
+    close(socket_fd);
+    return refused && released;
+}
+
+/**
+ * @brief Attaches a 4 KiB memfd that claims to be 16 MiB.
+ * @return True if the server answered SGM_SERVER_ERROR_ATTACH (a mapping past the object would raise
+ * SIGBUS in a worker) and still serves the connection.
+ */
+static bool short_buffer_refused()
+{
+    int socket_fd = raw_connect();
+    int memory_fd = memfd_create("sgm_server_tb", MFD_CLOEXEC);
+    if (socket_fd < 0 || memory_fd < 0 || ftruncate(memory_fd, 4096) != 0)
+        return false;
+
+    sgm_server_request request = raw_request(SGM_SERVER_ATTACH);
+    request.id = 1;
+    request.buffer_bytes = 16 << 20;
+    bool sent = send_with_descriptors(socket_fd, request, &memory_fd, 1);
+    close(memory_fd);
+    sgm_server_reply reply;
+    bool refused = sent && recv(socket_fd, &reply, sizeof(reply), 0) == (ssize_t)sizeof(reply) &&
+                   reply.status == SGM_SERVER_ERROR_ATTACH;
+
+    // With no buffer attached, a default COMPUTE is rejected instead of touching the short mapping
+    request = raw_request(SGM_SERVER_COMPUTE);
+    request.id = 2;
+    request.config = sgm_default_config();
+    bool rejected = send(socket_fd, &request, sizeof(request), MSG_NOSIGNAL) == (ssize_t)sizeof(request) &&
+                    recv(socket_fd, &reply, sizeof(reply), 0) == (ssize_t)sizeof(reply) &&
+                    reply.status == SGM_SERVER_ERROR_REQUEST;
+    close(socket_fd);
+    return refused && rejected;
+}
+
+/**
+ * @brief Sends requests without reading a single reply until the server gives up on the connection.
+ * @return True if the server disconnected the stalled client (its replies would block a worker).
+ */
+static bool stalled_reader_disconnected()
+{
+    int socket_fd = raw_connect();
+    if (socket_fd < 0)
+        return false;
+    sgm_server_request request = raw_request(SGM_SERVER_COMPUTE);
+    bool disconnected = false;
+    for (int i = 0; i < SGM_SERVER_TB_STALL_REQUESTS && !disconnected; i++)
+        disconnected = send(socket_fd, &request, sizeof(request), MSG_NOSIGNAL) != (ssize_t)sizeof(request);
+
+    // The replies sent before the server gave up are still queued; end of file must follow them
+    sgm_server_reply reply;
+    pollfd readable = {socket_fd, POLLIN, 0};
+    ssize_t bytes = 1;
+    while (bytes > 0 && poll(&readable, 1, 1000) == 1)
+        bytes = recv(socket_fd, &reply, sizeof(reply), 0);
+    close(socket_fd);
+    return disconnected && bytes == 0;
+}
+
+/**
+ * @brief Client process: @p frames requests through the server, every map compared with @p reference.
+ * @return Process exit code (0 when every reply was OK and matched).
+ */
+static int run_client(int index, int frames, const sgm_image &left, const sgm_image &right, const int *reference)
+{
+    std::string error;
+    sgm_disparity_client client;
+    bool connected = false;
+    for (int attempt = 0; attempt < 500 && !(connected = client.connect(SGM_SERVER_TB_SOCKET, error)); attempt++)
+        usleep(10000);
+
+    size_t image_bytes = align_up(sizeof(float) * HEIGHT * WIDTH);
+    size_t disparity_bytes = align_up(sizeof(int) * HEIGHT * WIDTH);
+    size_t slot_bytes = 2 * image_bytes + disparity_bytes;
+    unsigned char *base = connected ? (unsigned char *)client.attach(SGM_SERVER_TB_DEPTH * slot_bytes, error) : 0;
+    if (!base)
+    {
+        std::cerr << "CRITICAL ERROR: client " << index << ": " << error << std::endl;
+        return 2;
+    }
+    for (int s = 0; s < SGM_SERVER_TB_DEPTH; s++)
+    {
+        std::memcpy(base + s * slot_bytes, &left.pixels[0], sizeof(float) * HEIGHT * WIDTH);
+        std::memcpy(base + s * slot_bytes + image_bytes, &right.pixels[0], sizeof(float) * HEIGHT * WIDTH);
+    }
+
+    sgm_config_t config = sgm_default_config();
+    int sent = 0, received = 0, mismatches = 0;
+    while (received < frames)
+    {
+        while (sent < frames && sent - received < SGM_SERVER_TB_DEPTH)
+        {
+            size_t slot = (sent % SGM_SERVER_TB_DEPTH) * slot_bytes;
+            if (!client.submit((uint64_t)sent, config, slot, slot + image_bytes, slot + 2 * image_bytes, error))
+            {
+                std::cerr << "CRITICAL ERROR: client " << index << ": " << error << std::endl;
+                return 2;
+            }
+            sent++;
+        }
+
+        sgm_server_reply reply;
+        if (!client.receive(reply, error))
+        {
+            std::cerr << "CRITICAL ERROR: client " << index << ": " << error << std::endl;
+            return 2;
+        }
+        const int *disparity = (const int *)(base + (reply.id % SGM_SERVER_TB_DEPTH) * slot_bytes + 2 * image_bytes);
+        if (reply.status != SGM_SERVER_OK || std::memcmp(disparity, reference, sizeof(int) * HEIGHT * WIDTH) != 0)
+            mismatches++;
+        received++;
+    }
+
+    // A disparity plane past the end of the buffer must be refused, not written
+    if (index == 0)
+    {
+        sgm_server_reply reply;
+        if (!client.submit(frames, config, 0, image_bytes, SGM_SERVER_TB_DEPTH * slot_bytes, error) ||
+            !client.receive(reply, error) || reply.status != SGM_SERVER_ERROR_REQUEST)
+        {
+            std::cerr << "CRITICAL ERROR: out-of-buffer request was not rejected" << std::endl;
+            return 1;
+        }
+        if (!extra_descriptors_refused())
+        {
+            std::cerr << "CRITICAL ERROR: a request with two descriptors was not refused and released" << std::endl;
+            return 1;
+        }
+        if (!short_buffer_refused())
+        {
+            std::cerr << "CRITICAL ERROR: a buffer shorter than its claimed size was attached" << std::endl;
+            return 1;
+        }
+        if (!stalled_reader_disconnected())
+        {
+            std::cerr << "CRITICAL ERROR: a client that stopped reading was not disconnected" << std::endl;
+            return 1;
+        }
+    }
+
+    if (mismatches > 0)
+        std::cerr << "CRITICAL ERROR: client " << index << ": " << mismatches << " reply(ies) failed or differ"
+                  << std::endl;
+    return mismatches > 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int clients = (argc > 1) ? std::atoi(argv[1]) : 3;
+    int frames = (argc > 2) ? std::atoi(argv[2]) : 8;
+    int workers = (argc > 3) ? std::atoi(argv[3]) : 2;
+    int max_batch = (argc > 4) ? std::atoi(argv[4]) : 4;
+    if (clients < 1)
+        clients = 1;
+    if (frames < 1)
+        frames = 1;
+
+    std::string error;
+    sgm_image left, right;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    // Reference map from the top-level IP, inherited by the client processes
+    int *reference = new int[HEIGHT * WIDTH];
+    sgm_hls(&left.pixels[0], &right.pixels[0], reference);
+
+    std::cout << ">>> SGM Disparity Server: " << clients << " client(s) x " << frames << " frame(s), " << workers
+              << " worker(s), batches of up to " << max_batch << " on " << SGM_SERVER_TB_SOCKET << std::endl;
+
+    std::vector<pid_t> children;
+    for (int c = 0; c < clients; c++)
+    {
+        pid_t child = fork();
+        if (child < 0)
+        {
+            std::cerr << "CRITICAL ERROR: fork failed" << std::endl;
+            return -1;
+        }
+        if (child == 0)
+            _exit(run_client(c, frames, left, right, reference));
+        children.push_back(child);
+    }
+
+    sgm_disparity_server server;
+    if (!server.start(SGM_SERVER_TB_SOCKET, workers, max_batch, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread io_thread(&sgm_disparity_server::run, &server);
+
+    int failed = 0;
+    for (size_t c = 0; c < children.size(); c++)
+    {
+        int status = 0;
+        waitpid(children[c], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failed++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    server.request_stop();
+    io_thread.join();
+
+    uint64_t requests, batches;
+    server.statistics(requests, batches);
+    std::printf(">>> Served %llu request(s) in %llu batch(es) (mean batch %.2f) in %.3f s: %.2f frames/s\n",
+                (unsigned long long)requests, (unsigned long long)batches,
+                batches > 0 ? (double)requests / batches : 0.0, seconds, clients * frames / seconds);
+
+    delete[] reference;
+    if (failed > 0)
+    {
+        std::cerr << ">>> " << failed << " client process(es) reported failure." << std::endl;
+        return 1;
+    }
+    std::cout << ">>> Server round trip verified." << std::endl;
+    return 0;
+}
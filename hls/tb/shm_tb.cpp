@@ -0,0 +1,183 @@
+#include "sgm_hls.h"
+#include "image_io.h"
+#include "shm_ring.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sched.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @file shm_tb.cpp
+ * @brief Shared-memory frame exchange between a capture process and the engine.
+ *
+ * The engine creates an input ring of stereo frames and an output ring of disparity maps, then forks a
+ * stand-in capture process that attaches to both by name. The capture side publishes the test pair
+ * repeatedly and checks every returned map against a reference run. The engine side is sgm_shm_serve(),
+ * which computes directly from the input slot into the output slot, so no frame is copied between the
+ * processes.
+ *
+ * Usage: shm_tb [frames] [slots]
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+#ifndef SGM_SHM_INPUT_NAME
+#define SGM_SHM_INPUT_NAME "/sgm_frames"
+#endif
+
+#ifndef SGM_SHM_OUTPUT_NAME
+#define SGM_SHM_OUTPUT_NAME "/sgm_disparity"
+#endif
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Capture stand-in: publishes @p frames stereo frames and verifies the returned disparity maps.
+ * @return Process exit code (0 when every map matched the reference).
+ */
+static int run_capture(int frames, const sgm_image &left, const sgm_image &right, const int *reference)
+{
+    std::string error;
+    sgm_shm_ring input, output;
+    if (!input.open(SGM_SHM_INPUT_NAME, error) || !output.open(SGM_SHM_OUTPUT_NAME, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return 2;
+    }
+
+    int sent = 0, received = 0, mismatches = 0;
+    while (received < frames)
+    {
+        bool progress = false;
+        void *slot = (sent < frames) ? input.acquire_write() : 0;
+        if (slot)
+        {
+            sgm_shm_frame *frame = sgm_shm_frame_of(slot);
+            frame->sequence = (uint64_t)sent;
+            frame->timestamp_ns = now_ns();
+            frame->rows = HEIGHT;
+            frame->cols = WIDTH;
+            frame->status = 0;
+            std::memcpy(sgm_shm_left_plane(slot), &left.pixels[0], sizeof(float) * HEIGHT * WIDTH);
+            std::memcpy(sgm_shm_right_plane(slot), &right.pixels[0], sizeof(float) * HEIGHT * WIDTH);
+            input.commit_write();
+            if (++sent == frames)
+                input.mark_closed();
+            progress = true;
+        }
+
+        slot = output.acquire_read();
+        if (slot)
+        {
+            const sgm_shm_frame *frame = sgm_shm_frame_of(slot);
+            if (frame->status != 0 || frame->sequence != (uint64_t)received ||
+                std::memcmp(sgm_shm_disparity_plane(slot), reference, sizeof(int) * HEIGHT * WIDTH) != 0)
+                mismatches++;
+            output.release_read();
+            received++;
+            progress = true;
+        }
+
+        if (!progress)
+            sched_yield();
+    }
+
+    if (mismatches > 0)
+        std::cerr << "CRITICAL ERROR: " << mismatches << " disparity map(s) differ from the reference" << std::endl;
+    return mismatches > 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = (argc > 1) ? std::atoi(argv[1]) : 32;
+    int slot_count = (argc > 2) ? std::atoi(argv[2]) : 4;
+    if (frames < 1)
+        frames = 1;
+    if (slot_count < 1)
+        slot_count = 1;
+
+    std::string error;
+    sgm_image left, right;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    // Reference map from the top-level IP, inherited by the capture process
+    int *reference = new int[HEIGHT * WIDTH];
+    sgm_hls(&left.pixels[0], &right.pixels[0], reference);
+
+    sgm_shm_ring input, output;
+    if (!input.create(SGM_SHM_INPUT_NAME, slot_count, SGM_SHM_INPUT_SLOT_BYTES, error) ||
+        !output.create(SGM_SHM_OUTPUT_NAME, slot_count, SGM_SHM_OUTPUT_SLOT_BYTES, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    std::cout << ">>> SGM Shared-Memory Engine: " << frames << " frame(s) through " << slot_count << "-slot rings "
+              << SGM_SHM_INPUT_NAME << " / " << SGM_SHM_OUTPUT_NAME << std::endl;
+
+    sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+    if (!workspace)
+    {
+        std::cerr << "CRITICAL ERROR: cannot allocate the workspace" << std::endl;
+        return -1;
+    }
+
+    pid_t capture = fork();
+    if (capture < 0)
+    {
+        std::cerr << "CRITICAL ERROR: fork failed" << std::endl;
+        return -1;
+    }
+    if (capture == 0)
+        _exit(run_capture(frames, left, right, reference));
+
+    // Engine: read stereo planes in place, write disparity straight into the output slot
+    sgm_shm_serve_stats stats;
+    int64_t start_ns = now_ns();
+    bool engine_ok = sgm_shm_serve(input, output, sgm_default_config(), *workspace, stats, error);
+    if (!engine_ok)
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+    if (stats.failed > 0)
+    {
+        std::cerr << "CRITICAL ERROR: " << stats.failed << " frame(s) answered with an error status" << std::endl;
+        engine_ok = false;
+    }
+    double seconds = (now_ns() - start_ns) / 1e9;
+    int processed = (int)stats.frames;
+
+    int status = 0;
+    waitpid(capture, &status, 0);
+    int capture_code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+
+    std::printf(">>> Processed %d frame(s) in %.3f s (%.2f fps, mean capture-to-result latency %.2f ms)\n",
+                processed, seconds, processed / seconds, stats.latency_ns / 1e6 / (processed > 0 ? processed : 1));
+
+    sgm_destroy_workspace(workspace);
+    delete[] reference;
+
+    if (!engine_ok)
+        return 1;
+    if (capture_code != 0)
+    {
+        std::cerr << ">>> Capture process reported failure (exit code " << capture_code << ")." << std::endl;
+        return 1;
+    }
+    std::cout << ">>> Shared-memory round trip verified." << std::endl;
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "sgm_hls.h"
+#include "image_io.h"
+#include "stream_mux.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @file stream_mux_tb.cpp
+ * @brief Four camera streams of different geometry sharing one worker pool.
+ *
+ * Each stream crops its own frame from the test pair and has its own settings. The full-resolution
+ * stream is several times more expensive than the others and has the tightest deadline, so earliest-
+ * deadline-first alone would run its whole backlog first. All frames are queued before the workers
+ * start, as after a stall. Checks:
+ * - every computed map matches a direct sgm_compute() run of the stream's configuration
+ * - each stream completes in submission order
+ * - every stream has a frame done before half of the full-resolution backlog: no stream is starved
+ * - the stream with a short queue drops frames instead of queueing them
+ *
+ * Usage: stream_mux_tb [frames_per_stream] [workers]
+ */
+
+#ifndef DATA_PATH
+#define DATA_PATH "../../../data/processed/"
+#endif
+
+struct stream_test
+{
+    sgm_stream_settings settings;
+    std::vector<float> left, right; // Packed crop of the test pair
+    std::vector<int> reference;
+    std::vector<std::vector<int> > outputs; // One plane per submitted frame
+    std::vector<int> completion_position;   // Completion index of each computed frame
+    uint64_t next_sequence;
+    int callbacks, mismatches, out_of_order;
+};
+
+static void crop(const sgm_image &image, int rows, int cols, std::vector<float> &plane)
+{
+    plane.resize(rows * cols);
+    for (int y = 0; y < rows; y++)
+        std::memcpy(&plane[y * cols], &image.pixels[y * WIDTH], sizeof(float) * cols);
+}
+
+static sgm_stream_settings make_settings(const char *name, int rows, int cols, int paths, int subsample,
+                                         int64_t deadline_ms, int queue_depth)
+{
+    sgm_stream_settings settings;
+    settings.name = name;
+    settings.config = sgm_default_config();
+    settings.config.rows = rows;
+    settings.config.cols = cols;
+    settings.config.num_paths = paths;
+    settings.config.subsample = subsample;
+    settings.deadline_ns = deadline_ms * 1000000;
+    settings.weight = 1;
+    settings.queue_depth = queue_depth;
+    settings.degrade = 0;
+    return settings;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = (argc > 1) ? std::atoi(argv[1]) : 6;
+    int worker_count = (argc > 2) ? std::atoi(argv[2]) : 2;
+    if (frames < 2)
+        frames = 2;
+
+    std::string error;
+    sgm_image left, right;
+    if (!sgm_read_pixel_text(std::string(DATA_PATH) + "left_pixels.txt", WIDTH, HEIGHT, left, error) ||
+        !sgm_read_pixel_text(std::string(DATA_PATH) + "right_pixels.txt", WIDTH, HEIGHT, right, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+
+    std::vector<stream_test> tests(4);
+    tests[0].settings = make_settings("full", HEIGHT, WIDTH, 4, 1, 10, frames);
+    tests[1].settings = make_settings("half", HEIGHT / 2, WIDTH / 2, 2, 1, 100, frames);
+    tests[2].settings = make_settings("wide_sub2", 160, 200, 4, 2, 100, frames);
+    tests[3].settings = make_settings("small_q1", 80, 96, 8, 1, 100, 1);
+
+    // References from direct engine runs, before any worker starts
+    sgm_workspace_t *workspace = sgm_create_workspace(sgm_default_config());
+    for (size_t s = 0; s < tests.size(); s++)
+    {
+        stream_test &test = tests[s];
+        const sgm_config_t &config = test.settings.config;
+        if (!workspace || sgm_reserve_workspace(*workspace, config) != 0)
+        {
+            std::cerr << "CRITICAL ERROR: cannot allocate the reference workspace" << std::endl;
+            return -1;
+        }
+        crop(left, config.rows, config.cols, test.left);
+        crop(right, config.rows, config.cols, test.right);
+        test.reference.resize(config.rows * config.cols);
+        sgm_compute(config, &test.left[0], &test.right[0], &test.reference[0], *workspace);
+        test.outputs.assign(frames, std::vector<int>(config.rows * config.cols, -1));
+        test.next_sequence = 0;
+        test.callbacks = test.mismatches = test.out_of_order = 0;
+    }
+    sgm_destroy_workspace(workspace);
+
+    sgm_stream_mux mux;
+    std::mutex result_mutex;
+    int completions = 0;
+    for (size_t s = 0; s < tests.size(); s++)
+    {
+        stream_test &test = tests[s];
+        sgm_frame_callback done = [&test, &result_mutex, &completions](const sgm_frame_result &result) {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            test.callbacks++;
+            if (result.status != SGM_FRAME_DONE)
+                return;
+            if (result.sequence < test.next_sequence)
+                test.out_of_order++;
+            test.next_sequence = result.sequence + 1;
+            test.completion_position.push_back(completions++);
+            if (std::memcmp(result.disparity, &test.reference[0], sizeof(int) * test.reference.size()) != 0)
+                test.mismatches++;
+        };
+        if (mux.add_stream(test.settings, done, error) != (int)s)
+        {
+            std::cerr << "CRITICAL ERROR: " << error << std::endl;
+            return -1;
+        }
+    }
+
+    std::cout << ">>> SGM Stream Multiplexer: " << tests.size() << " streams x " << frames << " frame(s) on "
+              << worker_count << " worker(s)" << std::endl;
+
+    for (int f = 0; f < frames; f++)
+    {
+        for (size_t s = 0; s < tests.size(); s++)
+        {
+            stream_test &test = tests[s];
+            if (!mux.submit((int)s, f, &test.left[0], &test.right[0], &test.outputs[f][0], error))
+            {
+                std::cerr << "CRITICAL ERROR: " << error << std::endl;
+                return -1;
+            }
+        }
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!mux.start(worker_count, error))
+    {
+        std::cerr << "CRITICAL ERROR: " << error << std::endl;
+        return -1;
+    }
+    mux.drain();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    mux.stop();
+
+    int failures = 0;
+    int half_backlog = tests[0].completion_position.size() > (size_t)frames / 2
+                           ? tests[0].completion_position[frames / 2] : completions;
+    std::printf("%-10s %9s %6s %7s %5s %11s %14s %11s\n", "stream", "geometry", "frames", "dropped", "late",
+                "compute ms", "max latency ms", "first done");
+    for (size_t s = 0; s < tests.size(); s++)
+    {
+        const stream_test &test = tests[s];
+        sgm_stream_stats stats;
+        mux.statistics((int)s, stats);
+        int first = test.completion_position.empty() ? -1 : test.completion_position[0];
+        std::printf("%-10s %4dx%-4d %6llu %7llu %5llu %11.2f %14.2f %11d\n", test.settings.name.c_str(),
+                    test.settings.config.cols, test.settings.config.rows, (unsigned long long)stats.frames,
+                    (unsigned long long)stats.dropped, (unsigned long long)stats.late,
+                    stats.frames > 0 ? stats.compute_ns / 1e6 / stats.frames : 0.0, stats.max_latency_ns / 1e6, first);
+
+        if (test.callbacks != frames || test.mismatches > 0 || test.out_of_order > 0 ||
+            stats.frames + stats.dropped != (uint64_t)frames)
+        {
+            std::cerr << "CRITICAL ERROR: stream " << test.settings.name << ": " << test.callbacks << " callback(s), "
+                      << test.mismatches << " mismatch(es), " << test.out_of_order << " out of order" << std::endl;
+            failures++;
+        }
+        if (first < 0 || first > half_backlog)
+        {
+            std::cerr << "CRITICAL ERROR: stream " << test.settings.name << " first completed at position " << first
+                      << std::endl;
+            failures++;
+        }
+    }
+    sgm_stream_stats queued_stats;
+    mux.statistics(3, queued_stats);
+    if (queued_stats.dropped == 0)
+    {
+        std::cerr << "CRITICAL ERROR: the depth-1 stream dropped no frame of a burst" << std::endl;
+        failures++;
+    }
+
+    std::printf(">>> %d completion(s) in %.3f s\n", completions, seconds);
+    if (failures > 0)
+        return 1;
+    std::cout << ">>> Stream multiplexing verified." << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+"""Round trip of the test pair through the Python module `sgm` (hls/host/sgm_python.cpp).
+
+Checks that a NumPy frame comes back as the same disparity map as the C++ testbench reference
+(results/hls_disparity.txt), that out= is filled in place without a copy, and that strided,
+Fortran-order or wrongly typed arrays are rejected instead of being converted silently.
+
+Usage: built and run by hls/host/CMakeLists.txt (ctest), or
+    PYTHONPATH=<directory of the sgm module> SGM_ROOT=<repository root> python3 hls/tb/test_sgm_python.py
+"""
+
+import os
+import unittest
+
+import numpy as np
+import sgm
+
+ROOT = os.environ.get("SGM_ROOT", os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+
+
+def load_plane(relative_path, dtype):
+    """One value per line, row-major, as a (HEIGHT, WIDTH) C-contiguous array."""
+    values = np.loadtxt(os.path.join(ROOT, relative_path), dtype=dtype)
+    return np.ascontiguousarray(values.reshape(sgm.HEIGHT, sgm.WIDTH))
+
+
+class SgmPythonTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.left = load_plane("data/processed/left_pixels.txt", np.float32)
+        cls.right = load_plane("data/processed/right_pixels.txt", np.float32)
+        cls.reference = load_plane("results/hls_disparity.txt", np.int32)
+        cls.engine = sgm.Engine(sgm.Config())
+
+    def test_round_trip_matches_reference(self):
+        left, right = self.left.copy(), self.right.copy()
+        disparity = self.engine.compute(left, right)
+        self.assertEqual(disparity.dtype, np.int32)
+        self.assertEqual(disparity.shape, (sgm.HEIGHT, sgm.WIDTH))
+        self.assertTrue(disparity.flags.c_contiguous)
+        np.testing.assert_array_equal(disparity, self.reference)
+        # The engine reads the inputs in place and must leave them untouched
+        np.testing.assert_array_equal(left, self.left)
+        np.testing.assert_array_equal(right, self.right)
+
+    def test_out_is_filled_in_place(self):
+        out = np.full((sgm.HEIGHT, sgm.WIDTH), -1, dtype=np.int32)
+        result = self.engine.compute(self.left, self.right, out=out)
+        self.assertTrue(np.shares_memory(result, out))
+        self.assertEqual(result.__array_interface__["data"][0], out.__array_interface__["data"][0])
+        np.testing.assert_array_equal(out, self.reference)
+
+    def test_strided_input_is_rejected(self):
+        wide = np.zeros((sgm.HEIGHT, 2 * sgm.WIDTH), dtype=np.float32)
+        wide[:, ::2] = self.left
+        view = wide[:, ::2]
+        self.assertFalse(view.flags.c_contiguous)
+        with self.assertRaises(TypeError):
+            self.engine.compute(view, self.right)
+        # A contiguous copy of the same view is accepted
+        np.testing.assert_array_equal(self.engine.compute(np.ascontiguousarray(view), self.right), self.reference)
+
+    def test_fortran_order_and_dtype_are_rejected(self):
+        with self.assertRaises(TypeError):
+            self.engine.compute(np.asfortranarray(self.left), self.right)
+        with self.assertRaises(TypeError):
+            self.engine.compute(self.left.astype(np.float64), self.right)
+
+    def test_shape_is_checked(self):
+        with self.assertRaises(ValueError):
+            self.engine.compute(self.left[:-1], self.right[:-1])
+
+    def test_bad_out_is_rejected(self):
+        shape = (sgm.HEIGHT, sgm.WIDTH)
+        with self.assertRaises(TypeError):
+            self.engine.compute(self.left, self.right, out=np.zeros(shape, dtype=np.int64))
+        with self.assertRaises(TypeError):
+            self.engine.compute(self.left, self.right, out=np.zeros((sgm.HEIGHT, 2 * sgm.WIDTH), np.int32)[:, ::2])
+        with self.assertRaises(ValueError):
+            self.engine.compute(self.left, self.right, out=np.zeros((sgm.HEIGHT + 1, sgm.WIDTH), np.int32))
+        read_only = np.zeros(shape, dtype=np.int32)
+        read_only.flags.writeable = False
+        with self.assertRaises(ValueError):
+            self.engine.compute(self.left, self.right, out=read_only)
+
+
+if __name__ == "__main__":
+    unittest.main()